@@ -1,7 +1,13 @@
+#include <algorithm>
+#include <fstream>
 #include <iostream>
-#include <queue>
-#include <vector>
-#include <map>
+#include <memory>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+#include "Server.h"
+#include "Simulator.h"
 
 /*
 Project 2: CPU Scheduling and Memory Management
@@ -12,382 +18,203 @@ Jishan Rahman
 								  
 using namespace std;
 
-// Process States.
-enum ProcessState { 
-	NEW = 1,
-	READY,
-	RUNNING,
-	IOWAITING,
-	TERMINATED };
-
-// PCB structure
-struct PCB {
-    int processID;
-    int state;            // current state of PCB
-    int programCounter;   // Stored at mainMemoryBase + 2
-    int instructionBase;
-    int dataBase;
-    int memoryLimit;
-    int cpuCyclesUsed;    // total cpu cycles used 
-    int registerValue;
-    int maxMemoryNeeded; // max amount of memory needed
-    int mainMemoryBase;
-    vector<vector<int> > jobOperations;
-    
-    // variables needed to get infomation about the processes
-    int CPUAllocated;            // amount of time cpu is allowed
-    int runningTimeStart;        // when process started time
-    int terminationTime;         // when process ended time
-    int currentInstructionIndex; // where the next instruction is indexed at
-    int remainingInstructions;   // number of instructions left
-    int ioReleaseTime;           // global clock time when I/O wait ends
-    bool pendingPrint;           // condition if a print is pending
-    
-    PCB() :
-		processID(0),
-		state(NEW),
-		programCounter(0),
-		instructionBase(0),
-		dataBase(0),
-        memoryLimit(0),
-		cpuCyclesUsed(0),
-		registerValue(0),
-		maxMemoryNeeded(0),
-        mainMemoryBase(0),
-		CPUAllocated(0),
-		runningTimeStart(-1),
-		terminationTime(0),
-        currentInstructionIndex(0),
-		remainingInstructions(0),
-		ioReleaseTime(0),
-        pendingPrint(false) {}
-};
-
-// Check the IOWaitingQueue
-// If ioReleaseTime has passed
-// print I/O message while moving to readyQueue
-void IOQueueCheck(int globalClock, queue<PCB*>& ioWaitingQueue, queue<PCB*>& readyQueue) {
-    queue<PCB*> temp;
-    while (!ioWaitingQueue.empty()) {
-        PCB* ioProcesses = ioWaitingQueue.front();
-        ioWaitingQueue.pop();
-        if (globalClock >= (*ioProcesses).ioReleaseTime) {
-            cout << "print" << endl;
-													
-            cout << "Process " << (*ioProcesses).processID << " completed I/O and is moved to the ReadyQueue." << endl;
-            (*ioProcesses).state = READY;
-            readyQueue.push(ioProcesses);
+// Main function
+// Options: --checkpoint <time> <file>  snapshot the state at the first dispatch at or after time
+//          --restore <file>            resume from a snapshot instead of reading jobs from input
+//          --log <file>                write a binary event log alongside the text output
+//          --progress <ms> [file]      print live statistics every ms milliseconds to stderr or file
+//          --histograms [file]         print scheduler percentile tables at exit to stderr or file
+//          --io-interrupts [preempt]   complete I/O at its exact time, optionally preempting the running process
+//          --group-rr                  dispatch the ready members of a process group back to back
+//          --cache <words> <ways> <line> [hit miss]
+//                                      price STORE/LOAD with a set-associative LRU cache model
+//          --dvfs [levels]             scale COMPUTE by governed frequency levels (percent, default
+//                                      50,75,100) and report energy
+//          --admission <fifo|smallest|deadline> [limit]
+//                                      order and bound the queue of jobs waiting for memory
+//          --schedule <rr|edf|rms|stride|lottery [seed]>
+//                                      dispatch by round robin, earliest deadline, shortest period,
+//                                      or a proportional share of tickets
+//          --diff-logs <a> <b>         report the first divergent event of two logs
+//          --expand-log <file>         print a log in the text output format
+//          --serve <socket> [threads]  run job sets sent over a Unix socket (see Server.h)
+//          --submit <socket> [--trace] send the job set on stdin to a server and print its summary or trace
+int main(int argc, char* argv[]) {
+    long long checkpointTime = -1;
+    const char* checkpointPath = NULL;
+    const char* restorePath = NULL;
+    const char* logPath = NULL;
+    int progressInterval = 0;
+    const char* progressPath = NULL;
+    bool wantHistograms = false;
+    SimulatorConfig options;
+    const char* histogramPath = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--checkpoint") == 0 && i + 2 < argc) {
+            checkpointTime = atoll(argv[++i]);
+            checkpointPath = argv[++i];
+        } else if (strcmp(argv[i], "--restore") == 0 && i + 1 < argc) {
+            restorePath = argv[++i];
+        } else if (strcmp(argv[i], "--log") == 0 && i + 1 < argc) {
+            logPath = argv[++i];
+        } else if (strcmp(argv[i], "--progress") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0) {
+            progressInterval = atoi(argv[++i]);
+            if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0)
+                progressPath = argv[++i];
+        } else if (strcmp(argv[i], "--histograms") == 0) {
+            wantHistograms = true;
+            if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0)
+                histogramPath = argv[++i];
+        } else if (strcmp(argv[i], "--io-interrupts") == 0) {
+            options.ioInterrupts = true;
+            if (i + 1 < argc && strcmp(argv[i + 1], "preempt") == 0) {
+                options.ioPreemption = true;
+                i++;
+            }
+        } else if (strcmp(argv[i], "--group-rr") == 0) {
+            options.groupScheduling = true;
+        } else if (strcmp(argv[i], "--cache") == 0 && i + 3 < argc && atoll(argv[i + 1]) > 0 &&
+                   atoi(argv[i + 2]) > 0 && atoi(argv[i + 3]) > 0) {
+            options.cacheWords = atoll(argv[++i]);
+            options.cacheWays = atoi(argv[++i]);
+            options.cacheLineWords = atoi(argv[++i]);
+            if (i + 2 < argc && strncmp(argv[i + 1], "--", 2) != 0) {
+                options.cacheHitCycles = atoi(argv[++i]);
+                options.cacheMissCycles = atoi(argv[++i]);
+            }
+            if (options.cacheWords % ((long long)options.cacheWays * options.cacheLineWords) != 0) {
+                cerr << "Cache size must be a multiple of ways * line words" << endl;
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--dvfs") == 0) {
+            const char* levels = "50,75,100";
+            if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0)
+                levels = argv[++i];
+            for (const char* level = levels; level != NULL; level = strchr(level, ',')) {
+                level += *level == ',';
+                int percent = atoi(level);
+                if (percent <= 0) {
+                    cerr << "Invalid frequency levels " << levels << endl;
+                    return 1;
+                }
+                options.frequencyLevels.push_back(percent);
+            }
+            sort(options.frequencyLevels.begin(), options.frequencyLevels.end());
+        } else if (strcmp(argv[i], "--admission") == 0 && i + 1 < argc &&
+                   (strcmp(argv[i + 1], "fifo") == 0 || strcmp(argv[i + 1], "smallest") == 0 ||
+                    strcmp(argv[i + 1], "deadline") == 0)) {
+            i++;
+            options.admissionPolicy = strcmp(argv[i], "fifo") == 0 ? ADMIT_FIFO :
+                                      strcmp(argv[i], "smallest") == 0 ? ADMIT_SMALLEST : ADMIT_DEADLINE;
+            if (i + 1 < argc && atoi(argv[i + 1]) > 0)
+                options.admissionLimit = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--schedule") == 0 && i + 1 < argc &&
+                   (strcmp(argv[i + 1], "rr") == 0 || strcmp(argv[i + 1], "edf") == 0 ||
+                    strcmp(argv[i + 1], "rms") == 0 || strcmp(argv[i + 1], "stride") == 0 ||
+                    strcmp(argv[i + 1], "lottery") == 0)) {
+            i++;
+            options.schedulingPolicy = strcmp(argv[i], "rr") == 0 ? SCHEDULE_RR :
+                                       strcmp(argv[i], "edf") == 0 ? SCHEDULE_EDF :
+                                       strcmp(argv[i], "rms") == 0 ? SCHEDULE_RMS :
+                                       strcmp(argv[i], "stride") == 0 ? SCHEDULE_STRIDE : SCHEDULE_LOTTERY;
+            if (options.schedulingPolicy == SCHEDULE_LOTTERY && i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0)
+                options.lotterySeed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--diff-logs") == 0 && i + 2 < argc) {
+            return diffEventLogs(argv[i + 1], argv[i + 2], cout) ? 0 : 1;
+        } else if (strcmp(argv[i], "--expand-log") == 0 && i + 1 < argc) {
+            if (expandEventLog(argv[i + 1], cout))
+                return 0;
+            cerr << "Unable to read event log " << argv[i + 1] << endl;
+            return 1;
+        } else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+            return serveSimulations(argv[i + 1], i + 2 < argc ? atoi(argv[i + 2]) : 0);
+        } else if (strcmp(argv[i], "--submit") == 0 && i + 1 < argc) {
+            return submitSimulation(argv[i + 1], i + 2 < argc && strcmp(argv[i + 2], "--trace") == 0);
         } else {
-            temp.push(ioProcesses);
+            cerr << "Usage: " << argv[0] << " [--checkpoint <time> <file>] [--restore <file>] [--log <file>]" << endl;
+            cerr << "       " << string(strlen(argv[0]), ' ') << " [--progress <ms> [file]] [--histograms [file]]" << endl;
+            cerr << "       " << string(strlen(argv[0]), ' ') << " [--io-interrupts [preempt]] [--group-rr]" << endl;
+            cerr << "       " << string(strlen(argv[0]), ' ') << " [--cache <words> <ways> <line> [hit miss]] [--dvfs [levels]]" << endl;
+            cerr << "       " << string(strlen(argv[0]), ' ') << " [--admission <fifo|smallest|deadline> [limit]]"
+                 << " [--schedule <rr|edf|rms|stride|lottery [seed]>]" << endl;
+            cerr << "       " << argv[0] << " --diff-logs <a> <b> | --expand-log <file>" << endl;
+            cerr << "       " << argv[0] << " --serve <socket> [threads] | --submit <socket> [--trace]" << endl;
+            return 1;
         }
     }
-    while (!temp.empty()) {
-        ioWaitingQueue.push(temp.front());
-        temp.pop();
-    }
-}
 
-// Load PCB ID, instructions, and data into memory
-  
-void loadJobsToMemory(queue<PCB>& newJobQueue, queue<int>& readyMemoryQueue, vector<int>& mainMemory, int maxMemory) {
-    
-    // Initialize main memory with -1 to indicate empty slots
-    for (int i = 0; i < maxMemory; i++)
-        mainMemory.push_back(-1);
-    
-    // Process jobs from the new job queue
-    while (!newJobQueue.empty()) {
-        PCB job = newJobQueue.front();  // Get the next job
-        newJobQueue.pop();  // Remove it from the queue
-
-        int memoryIndex = job.mainMemoryBase;  // Starting index in memory
-        
-        // Store PCB header fields in memory
-        mainMemory[memoryIndex] = job.processID;
-        mainMemory[memoryIndex + 1] = job.state;
-        mainMemory[memoryIndex + 2] = job.programCounter;
-        mainMemory[memoryIndex + 3] = job.instructionBase;
-        mainMemory[memoryIndex + 4] = job.dataBase;
-        mainMemory[memoryIndex + 5] = job.memoryLimit;
-        mainMemory[memoryIndex + 6] = job.cpuCyclesUsed;
-        mainMemory[memoryIndex + 7] = job.registerValue;
-        mainMemory[memoryIndex + 8] = job.maxMemoryNeeded;
-        mainMemory[memoryIndex + 9] = job.mainMemoryBase;
-        
-        memoryIndex += 10;  // Move past PCB metadata
+    Simulator simulator;
+    simulator.configure(options);
+    simulator.setOutput(&cout);
+    unique_ptr<SchedulerHistograms> histograms;
+    if (wantHistograms) {
+        histograms.reset(new SchedulerHistograms());
+        simulator.setHistograms(histograms.get());
+    }
 
-        // Load job instructions into memory at the instruction base index
-        memoryIndex = job.instructionBase;
-        for (size_t i = 0; i < job.jobOperations.size(); i++) {
-            mainMemory[memoryIndex] = job.jobOperations[i][0];  // Store operation code
-            memoryIndex++;
+    if (restorePath != NULL) {
+        // resume a snapshot, its memory dump was already printed by the original run
+        if (!simulator.loadCheckpoint(restorePath)) {
+            cerr << "Unable to restore checkpoint " << restorePath << endl;
+            return 1;
         }
-
-        // Load job data into memory at the data base index
-        memoryIndex = job.dataBase;
-        for (size_t i = 0; i < job.jobOperations.size(); i++) {
-            for (size_t j = 1; j < job.jobOperations[i].size(); j++) {  // Skip first element (already stored)
-                mainMemory[memoryIndex] = job.jobOperations[i][j];  // Store data
-                memoryIndex++;
-            }
+    } else {
+        JobReader input(STDIN_FILENO);
+        if (!simulator.readJobs(input)) {
+            if (input.ok())
+                cerr << "Unable to map " << simulator.config().maxMemory << " words of simulated memory" << endl;
+            else
+                input.printError(cerr);
+            return 1;
         }
-    }
-}
 
+        // print all of memory to console
+        simulator.printMemory();
+    }
 
-// Main function
-int main() {
-    int maxMemory, CPUAllocated, contextSwitchTime, numProcesses;																	  
-    
-    // Read system parameters from input
-    cin >> maxMemory >> CPUAllocated >> contextSwitchTime >> numProcesses;					   
-    
-    // Declare necessary queues and memory structures
-    queue<PCB> newJobQueue;          // Queue for newly arriving jobs
-    queue<int> readyMemoryQueue;      // Queue to manage memory allocation
-    vector<int> mainMemory;           // Simulated main memory
-    vector<PCB*> processes;         // List of dynamically allocated processes
-    queue<PCB*> readyQueue;           // Queue for ready processes
-    queue<PCB*> ioWaitingQueue;       // Queue for processes waiting for I/O
-    
-    int processID;
-	int	instructionCount;
-    int inputType;
-	int	incomingInput;
-    int totalMem = 0; // Tracks memory usage
-						 
-    for (int i = 0; i < numProcesses; i++) {
-        PCB jobProcess;  // Create a new PCB instance																  
-        
-        // Read process ID, memory limit, and instruction count
-        cin >> jobProcess.processID >> jobProcess.memoryLimit >> instructionCount;									 
-
-        // Initialize PCB fields
-        jobProcess.remainingInstructions = instructionCount;
-        jobProcess.currentInstructionIndex = 0;
-        jobProcess.CPUAllocated = CPUAllocated;
-        jobProcess.runningTimeStart = -1;  // Process has not yet started running
-        jobProcess.ioReleaseTime = 0;      // No pending I/O operations
-        jobProcess.pendingPrint = false;   // No pending print operations
-        
-        // Memory layout setup
-        jobProcess.mainMemoryBase = totalMem;
-        jobProcess.maxMemoryNeeded = jobProcess.memoryLimit;
-        jobProcess.instructionBase = jobProcess.mainMemoryBase + 10; // Reserve first 10 slots for PCB header
-        jobProcess.dataBase = jobProcess.instructionBase + instructionCount;
-        totalMem += jobProcess.maxMemoryNeeded;
-
-        // Read process instructions
-        for (int j = 0; j < instructionCount; j++) {
-            cin >> inputType;
-            vector<int> opcode;
-            opcode.push_back(inputType);
+    if (logPath != NULL && !simulator.openEventLog(logPath, restorePath == NULL)) {
+        cerr << "Unable to open event log " << logPath << endl;
+        return 1;
+    }
 
-            // Read instruction parameters based on instruction type
-            switch (inputType) {
-                case 1: // Example: Operation requiring two parameters
-                    cin >> incomingInput;
-                    opcode.push_back(incomingInput);
-                    cin >> incomingInput;
-                    opcode.push_back(incomingInput);
-                    break;
-                case 2: // Example: Operation requiring one parameter
-                    cin >> incomingInput;
-                    opcode.push_back(incomingInput);
-                    break;
-                case 3: // Example: Another operation with two parameters
-                    cin >> incomingInput;
-                    opcode.push_back(incomingInput);
-                    cin >> incomingInput;
-                    opcode.push_back(incomingInput);
-                    break;
-                case 4: // Example: Operation requiring one parameter
-                    cin >> incomingInput;
-                    opcode.push_back(incomingInput);
-                    break;
+    // sample the statistics on a side thread until the run is over
+    ofstream progressFile;
+    unique_ptr<ProgressMonitor> progress;
+    if (progressInterval > 0) {
+        if (progressPath != NULL) {
+            progressFile.open(progressPath);
+            if (!progressFile) {
+                cerr << "Unable to open progress file " << progressPath << endl;
+                return 1;
             }
-
-            // Store the instruction in the job's operation list
-            jobProcess.jobOperations.push_back(opcode);
         }
-
-        // Add job to new job queue
-        newJobQueue.push(jobProcess);
-
-        // Reserve extra space in memory for the PCB metadata
-        totalMem += 10;  
-
-        // Dynamically allocate a new PCB object and store it in the process list
-        PCB* pProc = new PCB(jobProcess);
-        processes.push_back(pProc);
-
-        // Add the process to the ready queue
-        readyQueue.push(pProc);
+        progress.reset(new ProgressMonitor(simulator.statistics(), progressPath != NULL ? progressFile : cerr,
+                                           progressInterval));
     }
-    
-    // Load jobs into memory
-    loadJobsToMemory(newJobQueue, readyMemoryQueue, mainMemory, maxMemory);
-    
-    // print all of memory to console
-	for (int i = 0; i < maxMemory; i++) {
-        cout << i << " : " << mainMemory[i] << endl;
+
+    // snapshot once at the first dispatch boundary at or after the requested time
+    if (checkpointPath != NULL) {
+        simulator.runUntil(checkpointTime);
+        if (!simulator.finished() && !simulator.saveCheckpoint(checkpointPath))
+            cerr << "Unable to write checkpoint " << checkpointPath << endl;
     }
-    
-    int globalClock = 0;
 
-    //map termination times and its process
-    map<int,int> terminationTimes;
-								  
-    
     // Run the simulation loop until all processes have terminated
-    while (!readyQueue.empty() || !ioWaitingQueue.empty()) {
-        // If readyQueue empty but processes are awaiting on I/O update the clock
-	
-        while (readyQueue.empty() && !ioWaitingQueue.empty()) {
-            IOQueueCheck(globalClock, ioWaitingQueue, readyQueue);
-            if(readyQueue.empty())
-                globalClock += contextSwitchTime;
-            continue;
-        }
-        
-        // context switch out to next process
-        PCB* currentProc = readyQueue.front();
-        readyQueue.pop();
-        globalClock += contextSwitchTime; // add in context switch time
-        cout << "Process " << (*currentProc).processID << " has moved to Running." << endl;
-        
-        // Record start time if this is the first time the process is scheduled
-        if ((*currentProc).runningTimeStart == -1) (*currentProc).runningTimeStart = globalClock;
-        
-        int sliceCycles = 0;       // Tracks the number of CPU cycles used within the current time slice
-        bool ioOccurred = false;   // Flag to indicate if an I/O operation occurred during execution
-        bool timeoutOccurred = false; // Flag to indicate if the process has reached its time slice limit
+    simulator.run();
+    progress.reset();
 
-        // Execute until the time expires or an I/O event comes in
-        while ((*currentProc).remainingInstructions > 0 && sliceCycles < (*currentProc).CPUAllocated) {
-            vector<int>& instr = (*currentProc).jobOperations[(*currentProc).currentInstructionIndex];
-            int instrType = instr[0];
-            
-            // if instruction is COMPUTE
-            if (instrType == 1) { 
-                int cost = instr[2];
-                cout << "compute" << endl;
-                sliceCycles += cost;
-                (*currentProc).cpuCyclesUsed += cost;
-                globalClock += cost;
-                mainMemory[(*currentProc).mainMemoryBase + 6] = (*currentProc).cpuCyclesUsed;
-                (*currentProc).currentInstructionIndex++;
-                (*currentProc).remainingInstructions--;
-                mainMemory[(*currentProc).mainMemoryBase + 2] = (*currentProc).currentInstructionIndex;
-                if (sliceCycles >= (*currentProc).CPUAllocated)
-                    timeoutOccurred = true;
-            }
-            // if instruction is PRINT
-            else if (instrType == 2) { 
-                int printCycles = instr[1];
-                (*currentProc).cpuCyclesUsed += printCycles;
-                mainMemory[(*currentProc).mainMemoryBase + 6] = (*currentProc).cpuCyclesUsed;
-                (*currentProc).pendingPrint = true;
-                (*currentProc).ioReleaseTime = globalClock + printCycles;										 
-                cout << "Process " << (*currentProc).processID << " issued an IOInterrupt and moved to the IOWaitingQueue." << endl;
-                (*currentProc).currentInstructionIndex++;
-                (*currentProc).remainingInstructions--;
-                mainMemory[(*currentProc).mainMemoryBase + 2] = (*currentProc).currentInstructionIndex;
-                ioOccurred = true;
-                break;
-            }
-            // if instruction is STORE
-            else if (instrType == 3) { 
-                cout << "stored" << endl;
-                sliceCycles += 1;
-                (*currentProc).cpuCyclesUsed += 1;
-                globalClock += 1;
-                mainMemory[(*currentProc).mainMemoryBase + 6] = (*currentProc).cpuCyclesUsed;
-                int value = instr[1];
-                int address = instr[2];
-                if (address < (*currentProc).memoryLimit &&
-                    ((*currentProc).mainMemoryBase + address) < mainMemory.size()) {
-                    mainMemory[(*currentProc).mainMemoryBase + address] = value;
-                    (*currentProc).registerValue = value;
-                    mainMemory[(*currentProc).mainMemoryBase + 7] = value;
-                } else {
-                    cout << "store error!" << endl;
-                }
-                (*currentProc).currentInstructionIndex++;
-                (*currentProc).remainingInstructions--;
-                mainMemory[(*currentProc).mainMemoryBase + 2] = (*currentProc).currentInstructionIndex;
-                if (sliceCycles >= (*currentProc).CPUAllocated)
-                    timeoutOccurred = true;
-            }
-            // if instruction is LOAD
-            else if (instrType == 4) { 
-                cout << "loaded" << endl;
-                sliceCycles += 1;
-                (*currentProc).cpuCyclesUsed += 1;
-                globalClock += 1;
-                mainMemory[(*currentProc).mainMemoryBase + 6] = (*currentProc).cpuCyclesUsed;
-                int offset = instr[1];
-                if (offset < (*currentProc).memoryLimit &&
-                    ((*currentProc).mainMemoryBase + offset) < mainMemory.size()) {
-                    (*currentProc).registerValue = mainMemory[(*currentProc).mainMemoryBase + offset];
-                    mainMemory[(*currentProc).mainMemoryBase + 7] = (*currentProc).registerValue;
-                } else {
-                    cout << "load error!" << endl;
-                    (*currentProc).registerValue = -1;
-                    mainMemory[(*currentProc).mainMemoryBase + 7] = -1;
-                }
-                (*currentProc).currentInstructionIndex++;
-                (*currentProc).remainingInstructions--;
-                mainMemory[(*currentProc).mainMemoryBase + 2] = (*currentProc).currentInstructionIndex;
-                if (sliceCycles >= (*currentProc).CPUAllocated)
-                    timeoutOccurred = true;
-            }
-        }
-        
-        // check if any more instructions are left, if io push to ioWaitingQueue, if timeout push to readyQueue
-        if ((*currentProc).remainingInstructions > 0) {
-            if (ioOccurred) {
-                ioWaitingQueue.push(currentProc);
-                IOQueueCheck(globalClock, ioWaitingQueue, readyQueue);
-            }
-            else if (timeoutOccurred) {
-                cout << "Process " << (*currentProc).processID 
-                     << " has a TimeOUT interrupt and is moved to the ReadyQueue." << endl;
-                readyQueue.push(currentProc);
-                IOQueueCheck(globalClock, ioWaitingQueue, readyQueue);
-            }
-            else {
-                cout << "ERROR" << endl;
-                readyQueue.push(currentProc);
+    if (histograms) {
+        if (histogramPath == NULL) {
+            histograms->print(cerr);
+        } else {
+            ofstream histogramFile(histogramPath);
+            histograms->print(histogramFile);
+            if (!histogramFile) {
+                cerr << "Unable to write histograms to " << histogramPath << endl;
+                return 1;
             }
         }
-        else {  
-            int pc = (*currentProc).mainMemoryBase + 9;
-            mainMemory[(*currentProc).mainMemoryBase + 2] = pc;
-            (*currentProc).terminationTime = globalClock;
-
-            int totalCyclesConsumed = (*currentProc).terminationTime - (*currentProc).runningTimeStart;
-            cout << "Process ID: " << (*currentProc).processID << endl;
-            cout << "State: TERMINATED" << endl;
-            cout << "Program Counter: " << pc << endl;
-            cout << "Instruction Base: " << (*currentProc).instructionBase << endl;
-            cout << "Data Base: " << (*currentProc).dataBase << endl;
-            cout << "Memory Limit: " << (*currentProc).memoryLimit << endl;
-            cout << "CPU Cycles Used: " << (*currentProc).cpuCyclesUsed << endl;
-            cout << "Register Value: " << (*currentProc).registerValue << endl;
-            cout << "Max Memory Needed: " << (*currentProc).maxMemoryNeeded << endl;
-            cout << "Main Memory Base: " << (*currentProc).mainMemoryBase << endl;
-            cout << "Total CPU Cycles Consumed: " << totalCyclesConsumed << endl;
-            cout << "Process " << (*currentProc).processID << " terminated. Entered running state at: " << (*currentProc).runningTimeStart << ". Terminated at: " << (*currentProc).terminationTime << ". Total Execution Time: " << totalCyclesConsumed << "." << endl;
-																		 
-            // add in final termination time
-            terminationTimes[(*currentProc).processID] = (*currentProc).terminationTime;
-            IOQueueCheck(globalClock, ioWaitingQueue, readyQueue);
-        }
     }
-    
-    // total CPU time used by all processes
-    cout << "Total CPU time used: " << (globalClock + contextSwitchTime) << "." << endl;
-    
+
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,268 @@
+#include "Server.h"
+#include "Simulator.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+// Write all of data to fd, false once the peer has gone away
+static bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = send(fd, data, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+// Read fd until end of file into out, false on a read error
+static bool readAll(int fd, vector<char>& out) {
+    char chunk[1 << 16];
+    for (;;) {
+        ssize_t n = read(fd, chunk, sizeof(chunk));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            return false;
+        if (n == 0)
+            return true;
+        out.insert(out.end(), chunk, chunk + n);
+    }
+}
+
+// Stream buffer that sends to a socket in 64 KB blocks; after the peer goes
+// away further output is dropped and failed() is set
+class SocketBuf : public streambuf {
+public:
+    explicit SocketBuf(int fd) : fd(fd), broken(false), buffer(1 << 16) {
+        setp(buffer.data(), buffer.data() + buffer.size());
+    }
+
+    ~SocketBuf() { flushBuffer(); }
+
+    bool failed() const { return broken; }
+
+protected:
+    int overflow(int c) {
+        if (!flushBuffer())
+            return traits_type::eof();
+        if (c != traits_type::eof()) {
+            *pptr() = (char)c;
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+
+    int sync() { return flushBuffer() ? 0 : -1; }
+
+private:
+    bool flushBuffer() {
+        if (!broken && !writeAll(fd, pbase(), pptr() - pbase()))
+            broken = true;
+        setp(buffer.data(), buffer.data() + buffer.size());
+        return !broken;
+    }
+
+    int fd;
+    bool broken;
+    vector<char> buffer;
+};
+
+// A pool thread and the simulator it reuses for every connection it serves
+struct ServerWorker {
+    Simulator simulator;
+    ostream* summary;  // where the summary hook writes, NULL in trace mode
+
+    ServerWorker() : summary(NULL) {
+        simulator.addEventHook([this](const SimulatorEvent& event) {
+            if (summary == NULL)
+                return;
+            const LogRecord& r = event.record;
+            if (r.type == LOG_TERMINATED)
+                *summary << "Process " << r.processID << " terminated at " << r.time
+                         << ". Entered running state at: " << event.pcbWords[8] << ".\n";
+            else if (r.type == LOG_TOTAL)
+                writeEventText(*summary, r, NULL);
+        });
+    }
+
+    // Run one connection: read the request, run it and stream back the result
+    void serve(int client) {
+        vector<char> request;
+        if (!readAll(client, request))
+            return;
+        const char* body = (const char*)memchr(request.data(), '\n', request.size());
+        size_t headerSize = body != NULL ? body - request.data() : 0;
+        bool trace = body != NULL && string(request.data(), headerSize) == "trace";
+        if (body == NULL || (!trace && string(request.data(), headerSize) != "summary")) {
+            const char error[] = "ERROR expected \"trace\" or \"summary\" on the first line\n";
+            writeAll(client, error, sizeof(error) - 1);
+            return;
+        }
+        body++;
+        size_t bodySize = request.size() - headerSize - 1;
+
+        SocketBuf buf(client);
+        ostream out(&buf);
+        simulator.reset();
+        simulator.setOutput(NULL);
+        summary = NULL;
+
+        int magic = 0;
+        if (bodySize >= sizeof(magic))
+            memcpy(&magic, body, sizeof(magic));
+        bool restored = magic == CHECKPOINT_MAGIC;
+        if (restored) {
+            if (!simulator.restoreCheckpoint(body, bodySize)) {
+                out << "ERROR invalid checkpoint image\n";
+                return;
+            }
+        } else {
+            JobReader input(body, bodySize);
+            if (!simulator.readJobs(input)) {
+                out << "ERROR ";
+                if (input.ok())
+                    out << "unable to map " << simulator.config().maxMemory << " words of simulated memory\n";
+                else
+                    input.printError(out);
+                return;
+            }
+        }
+        vector<char>().swap(request);
+
+        out << "OK\n";
+        if (trace) {
+            simulator.setOutput(&out);
+            if (!restored)
+                simulator.printMemory();
+        } else {
+            summary = &out;
+        }
+
+        // stop early once the client has hung up
+        while (!buf.failed() && simulator.step()) {}
+        out.flush();
+        simulator.setOutput(NULL);
+        summary = NULL;
+    }
+};
+
+// Accepted connections waiting for a worker
+struct ConnectionQueue {
+    mutex lock;
+    condition_variable ready;
+    queue<int> clients;
+};
+
+int serveSimulations(const char* socketPath, int threads) {
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(socketPath) >= sizeof(address.sun_path)) {
+        cerr << "Socket path too long: " << socketPath << endl;
+        return 1;
+    }
+    strcpy(address.sun_path, socketPath);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(socketPath);
+    if (listener < 0 || bind(listener, (sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 128) != 0) {
+        cerr << "Unable to listen on " << socketPath << ": " << strerror(errno) << endl;
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    if (threads <= 0)
+        threads = max(1u, thread::hardware_concurrency());
+    ConnectionQueue pending;
+    vector<thread> pool;
+    for (int t = 0; t < threads; t++) {
+        pool.push_back(thread([&pending]() {
+            ServerWorker worker;
+            for (;;) {
+                int client;
+                {
+                    unique_lock<mutex> guard(pending.lock);
+                    pending.ready.wait(guard, [&pending]() { return !pending.clients.empty(); });
+                    client = pending.clients.front();
+                    pending.clients.pop();
+                }
+                worker.serve(client);
+                close(client);
+            }
+        }));
+    }
+
+    cerr << "Serving simulations on " << socketPath << " with " << threads << " workers" << endl;
+    for (;;) {
+        int client = accept(listener, NULL, NULL);
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            cerr << "accept failed: " << strerror(errno) << endl;
+            break;
+        }
+        {
+            lock_guard<mutex> guard(pending.lock);
+            pending.clients.push(client);
+        }
+        pending.ready.notify_one();
+    }
+    close(listener);
+    _exit(1);  // workers block forever on the queue
+}
+
+int submitSimulation(const char* socketPath, bool trace) {
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, socketPath, sizeof(address.sun_path) - 1);
+    int server = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server < 0 || connect(server, (sockaddr*)&address, sizeof(address)) != 0) {
+        cerr << "Unable to connect to " << socketPath << ": " << strerror(errno) << endl;
+        return 1;
+    }
+
+    vector<char> jobs;
+    string header = trace ? "trace\n" : "summary\n";
+    if (!readAll(STDIN_FILENO, jobs) || !writeAll(server, header.data(), header.size()) ||
+        !writeAll(server, jobs.data(), jobs.size())) {
+        cerr << "Unable to send jobs to " << socketPath << endl;
+        return 1;
+    }
+    shutdown(server, SHUT_WR);
+
+    // the status line comes first, everything after it is passed through
+    string status;
+    char c;
+    for (ssize_t n; (n = read(server, &c, 1)) == 1 && c != '\n';)
+        status += c;
+    if (status != "OK") {
+        cerr << (status.empty() ? "No response from server" : status) << endl;
+        return 1;
+    }
+    char chunk[1 << 16];
+    for (ssize_t n; (n = read(server, chunk, sizeof(chunk))) > 0;)
+        fwrite(chunk, 1, n, stdout);
+    fflush(stdout);
+    close(server);
+    return 0;
+}
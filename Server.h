@@ -0,0 +1,30 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+/*
+Project 2: CPU Scheduling and Memory Management
+CS 3113
+Spring 2025
+Jishan Rahman
+
+Simulation server: runs job sets sent over a Unix domain socket on a pool of
+reused Simulator instances.
+
+Protocol, one job set per connection:
+  request   "trace\n" or "summary\n", then a job file (text) or a checkpoint
+            image (binary, as written by --checkpoint), then the client shuts
+            down its sending side
+  response  "OK\n" followed by the output, or "ERROR <message>\n"
+A trace is the output the CLI prints for the same input; a summary is one line
+per terminated process and the total CPU time. Checkpoint images are
+validated before they run; one that is truncated or inconsistent is answered
+with "ERROR invalid checkpoint image".
+*/
+
+// Listen on socketPath and serve job sets on threads workers until killed
+int serveSimulations(const char* socketPath, int threads);
+
+// Send the job set on stdin to the server at socketPath and print the response
+int submitSimulation(const char* socketPath, bool trace);
+
+#endif
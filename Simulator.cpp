@@ -0,0 +1,2499 @@
+#include "Simulator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+const int PCB_HEADER_WORDS = 10;
+
+JobReader::JobReader(int fd) :
+    data(NULL), cur(NULL), end(NULL), mappedSize(0), error(NULL), errorAt(NULL), lastToken(NULL) {
+    // scanning reads up to 8 bytes at a time and stops on a NUL past the last byte: mapped
+    // files get those from the zero-filled tail of their last page, otherwise the input is read
+    struct stat info;
+    long pageSize = sysconf(_SC_PAGESIZE);
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0 &&
+        pageSize - info.st_size % pageSize >= (off_t)PADDING) {
+        void* mapped = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED) {
+            madvise(mapped, info.st_size, MADV_SEQUENTIAL);
+            mappedSize = info.st_size;
+            data = (const char*)mapped;
+            end = data + mappedSize;
+        }
+    }
+    if (data == NULL) {
+        const size_t chunk = 1 << 20;
+        size_t used = 0;
+        for (ssize_t n = 1; n > 0; used += n) {
+            buffer.resize(used + chunk);
+            n = read(fd, &buffer[used], chunk);
+            if (n < 0)
+                n = 0;
+        }
+        buffer.resize(used + PADDING);
+        memset(&buffer[used], 0, PADDING);
+        data = buffer.data();
+        end = data + used;
+    }
+    cur = data;
+}
+
+JobReader::JobReader(const char* text, size_t size) :
+    data(NULL), cur(NULL), end(NULL), mappedSize(0), error(NULL), errorAt(NULL), lastToken(NULL) {
+    buffer.resize(size + PADDING);
+    memcpy(buffer.data(), text, size);
+    memset(&buffer[size], 0, PADDING);
+    data = buffer.data();
+    end = data + size;
+    cur = data;
+}
+
+JobReader::~JobReader() {
+    if (mappedSize != 0)
+        munmap((void*)data, mappedSize);
+}
+
+void JobReader::printError(ostream& out) const {
+    int line = 1;
+    const char* lineStart = data;
+    for (const char* p = data; (p = (const char*)memchr(p, '\n', errorAt - p)) != NULL; lineStart = ++p)
+        line++;
+    out << "Input error at line " << line << ", column " << (errorAt - lineStart) + 1 << ": " << error << endl;
+}
+
+void readJobRecord(JobReader& input, JobRecord& job) {
+    int instructionCount;
+    int inputType;
+    int incomingInput;
+
+    // Read process ID, memory limit, and instruction count
+    input >> job.processID >> job.memoryLimit >> instructionCount;
+    job.operations.reserve(input.ok() && instructionCount > 0 ? instructionCount : 0);
+
+    // Read process instructions
+    for (int j = 0; j < instructionCount && input.ok(); j++) {
+        input >> inputType;
+        vector<int> opcode;
+        opcode.push_back(inputType);
+
+        // Read instruction parameters based on instruction type
+        switch (inputType) {
+            case 1: // Example: Operation requiring two parameters
+                input >> incomingInput;
+                opcode.push_back(incomingInput);
+                input >> incomingInput;
+                opcode.push_back(incomingInput);
+                break;
+            case 2: // Example: Operation requiring one parameter
+                input >> incomingInput;
+                opcode.push_back(incomingInput);
+                break;
+            case 3: // Example: Another operation with two parameters
+                input >> incomingInput;
+                opcode.push_back(incomingInput);
+                input >> incomingInput;
+                opcode.push_back(incomingInput);
+                break;
+            case 4: // Example: Operation requiring one parameter
+                input >> incomingInput;
+                opcode.push_back(incomingInput);
+                break;
+            case ADD:
+            case SUB:
+                input >> incomingInput;
+                opcode.push_back(incomingInput);
+                break;
+            case JUMP:
+            case BRANCH: // target may be instructionCount, the end of the job
+                input >> incomingInput;
+                if (incomingInput < 0 || incomingInput > instructionCount)
+                    input.reject("branch target outside the job");
+                opcode.push_back(incomingInput);
+                break;
+            case HALT:
+                break;
+            case SEND:
+            case RECV:
+                input >> incomingInput;
+                if (incomingInput < 0)
+                    input.reject("mailbox ID must not be negative");
+                opcode.push_back(incomingInput);
+                break;
+            default: // includes the decoded STORE/LOAD forms, which only the loader may produce
+                input.reject("unknown instruction");
+                break;
+        }
+
+        // Store the instruction in the job's operation list
+        job.operations.push_back(opcode);
+    }
+}
+
+// Read the jobs of a chunk that holds one job per line; false if the chunk is not laid out that way
+static bool readJobLines(JobReader& chunk, vector<JobRecord>& jobs) {
+    while (!chunk.atEnd()) {
+        jobs.push_back(JobRecord());
+        readJobRecord(chunk, jobs.back());
+        if (!chunk.ok() || !chunk.atLineEnd())
+            return false;
+    }
+    return true;
+}
+
+const size_t PARALLEL_PARSE_MIN_BYTES = 1 << 22;
+
+// Large inputs written one job per line (like sampleInput2.txt) are split at
+// line starts and parsed on all cores; the chunks are concatenated in input
+// order. Only the numProcesses job lines are split, the directives after them
+// are left to readJobDirectives. Anything else, including every malformed
+// input, goes through the serial reader.
+bool readJobRecords(JobReader& input, int numProcesses, vector<JobRecord>& jobs) {
+    const char* begin = input.position();
+    const char* limit = input.limit();
+    size_t threads = thread::hardware_concurrency();
+    if (threads > 1 && numProcesses > 1 && (size_t)(limit - begin) >= PARALLEL_PARSE_MIN_BYTES) {
+        // the job lines end after the rest of the header line and numProcesses more lines
+        const char* jobsEnd = begin;
+        for (int line = 0; line <= numProcesses && jobsEnd < limit; line++) {
+            const char* newline = (const char*)memchr(jobsEnd, '\n', limit - jobsEnd);
+            jobsEnd = newline != NULL ? newline + 1 : limit;
+        }
+
+        vector<const char*> splits(1, begin);
+        for (size_t t = 1; t < threads; t++) {
+            const char* split = begin + (jobsEnd - begin) * t / threads;
+            split = max(split, splits.back());
+            const char* newline = (const char*)memchr(split, '\n', jobsEnd - split);
+            splits.push_back(newline != NULL ? newline + 1 : jobsEnd);
+        }
+        splits.push_back(jobsEnd);
+
+        vector<vector<JobRecord> > arenas(threads);
+        vector<char> lineBased(threads, 0);
+        vector<thread> workers;
+        for (size_t t = 0; t < threads; t++) {
+            workers.push_back(thread([&, t]() {
+                JobReader chunk(input, splits[t], splits[t + 1]);
+                lineBased[t] = readJobLines(chunk, arenas[t]);
+            }));
+        }
+        size_t parsed = 0;
+        bool ok = true;
+        for (size_t t = 0; t < threads; t++) {
+            workers[t].join();
+            parsed += arenas[t].size();
+            ok = ok && lineBased[t];
+        }
+        if (ok && parsed == (size_t)numProcesses) {
+            jobs.reserve(parsed);
+            for (size_t t = 0; t < threads; t++) {
+                for (size_t i = 0; i < arenas[t].size(); i++) {
+                    jobs.push_back(JobRecord());
+                    jobs.back().processID = arenas[t][i].processID;
+                    jobs.back().memoryLimit = arenas[t][i].memoryLimit;
+                    jobs.back().operations.swap(arenas[t][i].operations);
+                }
+                vector<JobRecord>().swap(arenas[t]);
+            }
+            input.skipTo(jobsEnd);
+            return true;
+        }
+    }
+
+    jobs.assign(numProcesses > 0 ? numProcesses : 0, JobRecord());
+    for (int i = 0; i < numProcesses && input.ok(); i++)
+        readJobRecord(input, jobs[i]);
+    return input.ok();
+}
+
+bool readJobDirectives(JobReader& input, vector<JobRecord>& jobs, map<int,int>& mailboxCapacities) {
+    map<int, vector<size_t> > byID;
+    for (size_t i = 0; i < jobs.size(); i++)
+        byID[jobs[i].processID].push_back(i);
+    string directive;
+    while (input.readWord(directive)) {
+        if (directive == "mailbox") {
+            int mailboxID, capacity;
+            input >> mailboxID;
+            if (mailboxID < 0)
+                input.reject("mailbox ID must not be negative");
+            input >> capacity;
+            if (capacity < 0)
+                input.reject("mailbox capacity must not be negative");
+            mailboxCapacities[mailboxID] = capacity;
+            continue;
+        }
+        if (directive == "deadline") {
+            int pid;
+            long long deadline;
+            input >> pid;
+            map<int, vector<size_t> >::const_iterator job = byID.find(pid);
+            if (job == byID.end())
+                input.reject("no job with this process ID");
+            input >> deadline;
+            if (deadline <= 0)
+                input.reject("deadline must be positive");
+            for (size_t i = 0; input.ok() && i < job->second.size(); i++)
+                jobs[job->second[i]].deadline = deadline;
+            continue;
+        }
+        if (directive == "period") {
+            int pid;
+            long long period;
+            input >> pid;
+            map<int, vector<size_t> >::const_iterator job = byID.find(pid);
+            if (job == byID.end())
+                input.reject("no job with this process ID");
+            input >> period;
+            if (period <= 0)
+                input.reject("period must be positive");
+            for (size_t i = 0; input.ok() && i < job->second.size(); i++)
+                jobs[job->second[i]].period = period;
+            continue;
+        }
+        if (directive == "tickets") {
+            int pid, tickets;
+            input >> pid;
+            map<int, vector<size_t> >::const_iterator job = byID.find(pid);
+            if (job == byID.end())
+                input.reject("no job with this process ID");
+            input >> tickets;
+            if (tickets <= 0)
+                input.reject("tickets must be positive");
+            for (size_t i = 0; input.ok() && i < job->second.size(); i++)
+                jobs[job->second[i]].tickets = tickets;
+            continue;
+        }
+        if (directive != "group") {
+            input.reject("unknown directive");
+            break;
+        }
+        int groupID;
+        input >> groupID;
+        if (groupID <= 0)
+            input.reject("group ID must be positive");
+        while (input.ok() && !input.atLineEnd()) {
+            int pid;
+            input >> pid;
+            map<int, vector<size_t> >::const_iterator job = byID.find(pid);
+            if (job == byID.end()) {
+                input.reject("no job with this process ID");
+                break;
+            }
+            for (size_t i = 0; i < job->second.size(); i++) {
+                if (jobs[job->second[i]].groupID != 0)
+                    input.reject("job is already in a group");
+                jobs[job->second[i]].groupID = groupID;
+            }
+        }
+    }
+    return input.ok();
+}
+
+// Validate the static STORE/LOAD operands of a loaded job against its partition
+// and rewrite them into their unchecked or faulting forms
+template <bool Checked>
+static void decodeOperands(PCB& p, long long memorySize, ProgramTable& programs) {
+    if (Checked)
+        return;
+    Program decoded(*p.jobOperations);
+    for (size_t i = 0; i < decoded.size(); i++) {
+        vector<int>& instr = decoded[i];
+        if (instr[0] != STORE && instr[0] != LOAD)
+            continue;
+        int address = instr[0] == STORE ? instr[2] : instr[1];
+        bool inBounds = address < p.memoryLimit &&
+                        (unsigned long long)(p.mainMemoryBase + address) < (unsigned long long)memorySize;
+        if (instr[0] == STORE)
+            instr[0] = inBounds ? STORE_UNCHECKED : STORE_FAULT;
+        else
+            instr[0] = inBounds ? LOAD_UNCHECKED : LOAD_FAULT;
+    }
+    p.jobOperations = programs.intern(decoded);
+}
+
+// Whether a STORE/LOAD may touch its address; decoded forms carry the loader's verdict
+template <bool Checked>
+static inline bool operandInBounds(int instrType, int uncheckedType, int faultType,
+                                   const PCB& p, int address, long long memorySize) {
+    if (!Checked && (instrType == uncheckedType || instrType == faultType))
+        return instrType == uncheckedType;
+    return address < p.memoryLimit &&
+           (unsigned long long)(p.mainMemoryBase + address) < (unsigned long long)memorySize;
+}
+
+// Pass units a stride process advances per cycle run with one ticket
+const long long STRIDE_SCALE = 1 << 20;
+
+// Power model of the energy report, in thousandths of an energy unit per tick:
+// a static part, a dynamic part that grows with the cube of the frequency
+// (the voltage scales with it), and the draw of an idle CPU
+const long long STATIC_POWER = 300;
+const long long DYNAMIC_POWER = 700;  // at the nominal frequency
+const long long IDLE_POWER = 100;
+
+// Power of a busy CPU at a frequency level given in percent of nominal
+static inline long long levelPower(int percent) {
+    return STATIC_POWER + DYNAMIC_POWER * percent * percent * percent / 1000000;
+}
+
+// Add cycles to a clock or cycle counter; the overflow-checked build stops
+// with an error where the plain build would wrap
+static inline void addCycles(long long& total, long long cycles) {
+    if (!kOverflowChecked) {
+        total += cycles;
+    } else if (__builtin_add_overflow(total, cycles, &total)) {
+        cerr << "Cycle count overflow: adding " << cycles << " cycles overflows 64 bits" << endl;
+        abort();
+    }
+}
+
+// Statistics have a single writer, so a relaxed load and store is all an update costs
+static inline void bump(atomic<long long>& counter, long long amount = 1) {
+    counter.store(counter.load(memory_order_relaxed) + amount, memory_order_relaxed);
+}
+
+static inline void publish(atomic<long long>& counter, long long value) {
+    counter.store(value, memory_order_relaxed);
+}
+
+// Save the header words that change while a process runs (PC, CPU cycles, register)
+// back to mainMemory; called at context switch, I/O and termination boundaries
+static inline void writeBackHeader(const PCB& p, SimulatedMemory& mainMemory) {
+    mainMemory.set(p.mainMemoryBase + 2, p.currentInstructionIndex);
+    mainMemory.set(p.mainMemoryBase + 6, (int)p.cpuCyclesUsed);
+    mainMemory.set(p.mainMemoryBase + 7, p.registerValue);
+}
+
+// Load the PCB header, instructions, and data of a placed job into memory
+static void loadJobToMemory(const PCB& job, SimulatedMemory& mainMemory) {
+    // Store PCB header fields in memory as one block
+    int header[PCB_HEADER_WORDS] = { job.processID, job.state, job.programCounter, (int)job.instructionBase,
+                                     (int)job.dataBase, job.memoryLimit, (int)job.cpuCyclesUsed, job.registerValue,
+                                     job.maxMemoryNeeded, (int)job.mainMemoryBase };
+    mainMemory.write(job.mainMemoryBase, header, PCB_HEADER_WORDS);
+
+    // Load each instruction in one pass: the opcode goes to the instruction
+    // area and its operands follow the previous ones in the data area
+    const Program& operations = *job.jobOperations;
+    long long data = job.dataBase;
+    for (size_t i = 0; i < operations.size(); i++) {
+        const vector<int>& instr = operations[i];
+        mainMemory.write(job.instructionBase + i, instr.data(), 1);
+        mainMemory.write(data, instr.data() + 1, instr.size() - 1);
+        data += instr.size() - 1;
+    }
+}
+
+// Words a job takes in main memory: its PCB header and its memory limit
+static inline long long regionWords(const PCB& job) {
+    return PCB_HEADER_WORDS + max(0, job.maxMemoryNeeded);
+}
+
+const long long SimulatedMemory::CHUNK_WORDS;
+
+SimulatedMemory::~SimulatedMemory() {
+    if (words != NULL)
+        munmap(words, capacity);
+}
+
+bool SimulatedMemory::assign(long long size) {
+    size = max(size, 0LL);
+    if ((unsigned long long)size > SIZE_MAX / sizeof(int))
+        return false;
+    size_t bytes = (size_t)size * sizeof(int);
+    if (words != NULL && bytes <= capacity) {
+        // hand the written pages back to the kernel, they read as -1 again afterwards
+        for (long long c = 0; c < chunks(); c++) {
+            long long run = c;
+            while (run < chunks() && written[run])
+                run++;
+            if (run > c)
+                madvise(words + c * CHUNK_WORDS, (size_t)(min(run * CHUNK_WORDS, length) - c * CHUNK_WORDS) * sizeof(int),
+                        MADV_DONTNEED);
+            c = run;
+        }
+    } else {
+        if (words != NULL)
+            munmap(words, capacity);
+        words = NULL;
+        capacity = 0;
+        long pageSize = sysconf(_SC_PAGESIZE);
+        size_t mapped = (bytes + pageSize - 1) / pageSize * pageSize;
+        if (mapped > 0) {
+            void* region = mmap(NULL, mapped, PROT_READ | PROT_WRITE,
+                                MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+            if (region == MAP_FAILED) {
+                length = 0;
+                written.clear();
+                return false;
+            }
+            words = (int*)region;
+            capacity = mapped;
+        }
+    }
+    length = size;
+    written.assign((size + CHUNK_WORDS - 1) / CHUNK_WORDS, 0);
+    return true;
+}
+
+void SimulatedMemory::write(long long address, const int* values, long long count) {
+    if (address < 0) {
+        values -= address;
+        count += address;
+        address = 0;
+    }
+    count = min(count, length - address);
+    for (long long i = 0; i < count; i++)
+        words[address + i] = ~values[i];
+    for (long long c = address / CHUNK_WORDS; c * CHUNK_WORDS < address + count; c++)
+        written[c] = 1;
+}
+
+void SimulatedMemory::readChunk(long long chunk, int* out) const {
+    long long n = chunkWords(chunk);
+    if (!written[chunk]) {
+        fill(out, out + n, -1);
+        return;
+    }
+    const int* in = words + chunk * CHUNK_WORDS;
+    for (long long i = 0; i < n; i++)
+        out[i] = ~in[i];
+}
+
+Simulator::Simulator() :
+    output(NULL), histograms(NULL), eventLog(NULL), readyOrder(0), globalPass(0), shareWindowEnd(-1),
+    nextIoRelease(LLONG_MAX), preemptingReady(0),
+    ioInterrupted(false), globalClock(0), activeGroup(0), frequencyLevel(0), busyTime(0), busyEnergy(0),
+    admissionWaited(0), admissionRejected(0), admissionDelayTotal(0), admissionDelayMax(0), deadlineJobs(0),
+    deadlineMisses(0), latenessTotal(0), latenessMax(0), totalReported(false) {}
+
+Simulator::~Simulator() {
+    closeEventLog();
+    for (size_t i = 0; i < processes.size(); i++)
+        delete processes[i];
+}
+
+void Simulator::configure(const SimulatorConfig& config) {
+    configured = config;
+    settings = config;
+    cache.configure(config.cacheWords, config.cacheWays, config.cacheLineWords);
+    frequencyLevel = max(0, (int)settings.frequencyLevels.size() - 1);
+    lottery.reseed(settings.lotterySeed);
+}
+
+void Simulator::reset() {
+    // a job file or checkpoint overwrites some settings, the next run starts from the configured ones
+    settings = configured;
+    closeEventLog();
+    for (size_t i = 0; i < processes.size(); i++)
+        delete processes[i];
+    processes.clear();
+    readyQueue.clear();
+    readyHeap.clear();
+    readyOrder = 0;
+    lotteryReady.clear();
+    lottery.reseed(settings.lotterySeed);
+    globalPass = 0;
+    shareWindowEnd = -1;
+    ioWaitingQueue = queue<PCB*>();
+    nextIoRelease = LLONG_MAX;
+    terminations.clear();
+    processGroups.clear();
+    activeGroup = 0;
+    mailboxes.clear();
+    cache.flush();
+    frequencyLevel = max(0, (int)settings.frequencyLevels.size() - 1);
+    busyTime = 0;
+    busyEnergy = 0;
+    freeMemory.clear();
+    arrivals.clear();
+    admissionQueue.clear();
+    admissionWaited = 0;
+    admissionRejected = 0;
+    admissionDelayTotal = 0;
+    admissionDelayMax = 0;
+    deadlineJobs = 0;
+    deadlineMisses = 0;
+    latenessTotal = 0;
+    latenessMax = 0;
+    programTable.clear();
+    mainMemory.clear();
+    globalClock = 0;
+    totalReported = false;
+    publish(stats.dispatches, 0);
+    publish(stats.ioCompletions, 0);
+    publishTotals();
+}
+
+// Publish the statistics that follow from the loaded jobs and queues
+void Simulator::publishTotals() {
+    long long executed = 0, total = 0;
+    for (size_t i = 0; i < processes.size(); i++) {
+        executed += processes[i]->currentInstructionIndex;  // exact until a job branches backwards
+        total += (long long)processes[i]->jobOperations->size();
+    }
+    publish(stats.clock, globalClock);
+    publish(stats.instructions, executed);
+    publish(stats.totalInstructions, total);
+    publish(stats.readyDepth, (long long)readyCount());
+    publish(stats.ioWaitingDepth, (long long)ioWaitingQueue.size());
+    publish(stats.terminated, (long long)terminations.size());
+    publish(stats.jobs, (long long)processes.size());
+    publish(stats.admissionWaiting, (long long)(arrivals.size() + admissionQueue.size()));
+}
+
+bool Simulator::readJobs(JobReader& input) {
+    int numProcesses;
+
+    // Read system parameters from input
+    input >> settings.maxMemory >> settings.CPUAllocated >> settings.contextSwitchTime >> numProcesses;
+    vector<JobRecord> records;
+    map<int,int> mailboxCapacities;
+    if (!input.ok() || !readJobRecords(input, numProcesses, records) ||
+        !readJobDirectives(input, records, mailboxCapacities))
+        return false;
+    for (map<int,int>::const_iterator it = mailboxCapacities.begin(); it != mailboxCapacities.end(); ++it)
+        declareMailbox(it->first, it->second);
+    return loadJobs(records);
+}
+
+bool Simulator::loadJobs(vector<JobRecord>& records) {
+    size_t first = processes.size();
+
+    // Every word reads -1 (empty) until it is written, so only the jobs themselves are stored
+    if (first == 0) {
+        if (!mainMemory.assign(settings.maxMemory))
+            return false;
+        freeMemory.clear();
+        if (settings.maxMemory > 0)
+            freeMemory[0] = settings.maxMemory;
+    }
+
+    for (size_t i = 0; i < records.size(); i++) {
+        PCB jobProcess;  // Create a new PCB instance
+        int instructionCount = (int)records[i].operations.size();
+        jobProcess.processID = records[i].processID;
+        jobProcess.memoryLimit = records[i].memoryLimit;
+
+        // Initialize PCB fields
+        jobProcess.remainingInstructions = instructionCount;
+        jobProcess.currentInstructionIndex = 0;
+        jobProcess.CPUAllocated = settings.CPUAllocated;
+        jobProcess.runningTimeStart = -1;  // Process has not yet started running
+        jobProcess.ioReleaseTime = 0;      // No pending I/O operations
+        jobProcess.pendingPrint = false;   // No pending print operations
+        jobProcess.queuedSince = globalClock;
+        jobProcess.groupID = records[i].groupID;
+        jobProcess.period = records[i].period;
+        jobProcess.tickets = records[i].tickets > 0 ? records[i].tickets : DEFAULT_TICKETS;
+        jobProcess.slot = (int)processes.size();
+        jobProcess.deadline = records[i].deadline;
+        if (jobProcess.deadline == 0 && jobProcess.period > 0)
+            jobProcess.deadline = globalClock + jobProcess.period;  // implicit deadline, one period after arrival
+        jobProcess.maxMemoryNeeded = jobProcess.memoryLimit;
+        jobProcess.mainMemoryBase = -1;   // placed below or on admission
+
+        jobProcess.jobOperations = programTable.intern(records[i].operations);
+        Program().swap(records[i].operations);
+
+        // Dynamically allocate a new PCB object and store it in the process list
+        PCB* pProc = new PCB(jobProcess);
+        processes.push_back(pProc);
+        if (pProc->groupID != 0)
+            processGroups[pProc->groupID].push_back(pProc);
+
+        // Lay the jobs out in order, each right after the one before it, until
+        // one does not fit; that job and the ones after it wait for admission
+        long long base = arrivals.empty() ? allocateMemory(regionWords(*pProc)) : -1;
+        if (base < 0) {
+            arrivals.push_back(pProc);
+            continue;
+        }
+        placeJob(*pProc, base, false);
+
+        // Add the process to the ready queue
+        readyQueue.push_back(pProc);
+    }
+    publishTotals();
+    return true;
+}
+
+// First fit: carve words out of the lowest free region that holds them; -1 if none does
+long long Simulator::allocateMemory(long long words) {
+    for (map<long long,long long>::iterator it = freeMemory.begin(); it != freeMemory.end(); ++it) {
+        if (it->second < words)
+            continue;
+        long long base = it->first;
+        long long left = it->second - words;
+        freeMemory.erase(it);
+        if (left > 0)
+            freeMemory[base + words] = left;
+        return base;
+    }
+    return -1;
+}
+
+// Return a region to the free list, merging it with free neighbours
+void Simulator::releaseMemory(long long base, long long words) {
+    if (words <= 0)
+        return;
+    map<long long,long long>::iterator next = freeMemory.lower_bound(base);
+    if (next != freeMemory.end() && base + words == next->first) {
+        words += next->second;
+        next = freeMemory.erase(next);
+    }
+    if (next != freeMemory.begin()) {
+        map<long long,long long>::iterator before = prev(next);
+        if (before->first + before->second == base) {
+            before->second += words;
+            return;
+        }
+    }
+    freeMemory[base] = words;
+}
+
+// Give a job its region at base and load it; a reused region is wiped first
+void Simulator::placeJob(PCB& process, long long base, bool reused) {
+    process.mainMemoryBase = base;
+    process.instructionBase = base + PCB_HEADER_WORDS;  // Reserve first 10 slots for PCB header
+    process.dataBase = process.instructionBase + (long long)process.jobOperations->size();
+    if (reused) {
+        vector<int> empty((size_t)min(regionWords(process), SimulatedMemory::CHUNK_WORDS), -1);
+        for (long long done = 0; done < regionWords(process); done += (long long)empty.size())
+            mainMemory.write(base + done, empty.data(), min((long long)empty.size(), regionWords(process) - done));
+    }
+    loadJobToMemory(process, mainMemory);
+    decodeOperands<kCheckedBuild>(process, mainMemory.size(), programTable);
+}
+
+// Queue new arrivals under the admission policy, then admit from the head of
+// the queue for as long as the head fits in a free region
+void Simulator::admitJobs() {
+    // arrivals are always the last jobs loaded, so their index gives the arrival order
+    int firstArrival = (int)(processes.size() - arrivals.size());
+    for (size_t i = 0; i < arrivals.size(); i++) {
+        PCB* process = arrivals[i];
+        if (regionWords(*process) > settings.maxMemory) {
+            reject(process, REJECT_TOO_LARGE);
+        } else if (settings.admissionLimit > 0 && admissionQueue.size() >= (size_t)settings.admissionLimit) {
+            reject(process, REJECT_QUEUE_FULL);
+        } else {
+            long long key = 0;
+            if (settings.admissionPolicy == ADMIT_SMALLEST)
+                key = regionWords(*process);
+            else if (settings.admissionPolicy == ADMIT_DEADLINE)
+                key = process->deadline > 0 ? process->deadline : LLONG_MAX;
+            admissionQueue[make_pair(key, firstArrival + (int)i)] = process;
+            emit(LOG_ADMISSION_WAIT, process, -1, regionWords(*process));
+        }
+    }
+    arrivals.clear();
+
+    while (!admissionQueue.empty()) {
+        PCB* process = admissionQueue.begin()->second;
+        long long base = allocateMemory(regionWords(*process));
+        if (base < 0)
+            break;
+        admissionQueue.erase(admissionQueue.begin());
+        placeJob(*process, base, true);
+        long long waited = globalClock - process->queuedSince;
+        admissionWaited++;
+        admissionDelayTotal += waited;
+        admissionDelayMax = max(admissionDelayMax, waited);
+        if (histograms != NULL)
+            histograms->admissionDelay.record(waited);
+        emit(LOG_ADMITTED, process, -1, waited);
+        process->queuedSince = globalClock;
+        readyQueue.push_back(process);
+    }
+    publish(stats.admissionWaiting, (long long)admissionQueue.size());
+}
+
+// Turn a job away at admission; it never runs and is not counted as terminated
+void Simulator::reject(PCB* process, int reason) {
+    admissionRejected++;
+    emit(LOG_REJECTED, process, -1, reason);
+}
+
+void Simulator::printMemory() {
+    if (output == NULL)
+        return;
+    vector<int> words(SimulatedMemory::CHUNK_WORDS);
+    for (long long c = 0; c < mainMemory.chunks(); c++) {
+        long long first = c * SimulatedMemory::CHUNK_WORDS;
+        mainMemory.readChunk(c, words.data());
+        for (long long i = 0; i < mainMemory.chunkWords(c); i++)
+            *output << first + i << " : " << words[i] << '\n';
+    }
+}
+
+// Report an event of process at the current time
+void Simulator::emit(int type, const PCB* process, int instruction, long long value, const long long* pcbWords) {
+    LogRecord record = { type, process != NULL ? process->processID : 0, instruction, 0, globalClock, value };
+    emitRecord(record, process, pcbWords);
+}
+
+// Write the event to the text trace, the event log and every hook
+void Simulator::emitRecord(const LogRecord& record, const PCB* process, const long long* pcbWords) {
+    if (output != NULL)
+        writeEventText(*output, record, pcbWords);
+    if (eventLog != NULL) {
+        fwrite(&record, sizeof(record), 1, eventLog);
+        if (pcbWords != NULL)
+            fwrite(pcbWords, sizeof(int), record.value, eventLog);
+    }
+    if (!hooks.empty()) {
+        SimulatorEvent event = { record, process, pcbWords };
+        for (size_t i = 0; i < hooks.size(); i++)
+            hooks[i](event);
+    }
+}
+
+// The slice loop is compiled once per combination of the behaviour it has to
+// check for; the variant without tracing or interrupts has none of those branches
+template <bool Observed, bool IoInterrupts>
+struct EnginePolicy {
+    static const bool observed = Observed;          // events go to a trace, log, hook or histograms
+    static const bool ioInterrupts = IoInterrupts;  // SimulatorConfig::ioInterrupts
+    static const bool checked = kCheckedBuild;      // bounds checks at run time, fixed per build
+};
+
+// Check the IOWaitingQueue
+// If ioReleaseTime has passed
+// print I/O message while moving to readyQueue
+void Simulator::ioQueueCheck() {
+    queue<PCB*> temp;
+    nextIoRelease = LLONG_MAX;
+    while (!ioWaitingQueue.empty()) {
+        PCB* ioProcesses = ioWaitingQueue.front();
+        ioWaitingQueue.pop();
+        if (globalClock >= (*ioProcesses).ioReleaseTime) {
+            emit(LOG_IO_COMPLETED, ioProcesses, -1, 0);
+            bump(stats.ioCompletions);
+            if (histograms != NULL) {
+                histograms->ioLatency.record(globalClock - (*ioProcesses).queuedSince);
+                histograms->ioDelay.record(globalClock - (*ioProcesses).ioReleaseTime);
+            }
+            (*ioProcesses).queuedSince = globalClock;
+            (*ioProcesses).state = READY;
+            if (settings.ioInterrupts && settings.ioPreemption)
+                readyQueue.insert(readyQueue.begin() + preemptingReady++, ioProcesses);
+            else
+                readyQueue.push_back(ioProcesses);
+        } else {
+            nextIoRelease = min(nextIoRelease, (*ioProcesses).ioReleaseTime);
+            temp.push(ioProcesses);
+        }
+    }
+    while (!temp.empty()) {
+        ioWaitingQueue.push(temp.front());
+        temp.pop();
+    }
+}
+
+bool Simulator::step() {
+    if (!arrivals.empty())
+        admitJobs();
+    if (finished()) {
+        reportTotal();
+        return false;
+    }
+
+    // If readyQueue empty but processes are awaiting on I/O update the clock
+    while (readyCount() == 0 && !ioWaitingQueue.empty()) {
+        ioQueueCheck();
+        if (readyQueue.empty() && settings.ioInterrupts && nextIoRelease > globalClock)
+            globalClock = nextIoRelease;  // idle until the next interrupt
+        else if (readyQueue.empty())
+            addCycles(globalClock, settings.contextSwitchTime);
+    }
+
+    // context switch out to next process
+    PCB* currentProc = dequeueReady();
+    bump(stats.dispatches);
+    if (histograms != NULL) {
+        histograms->readyDepth.record((long long)readyCount());
+        histograms->ioWaitingDepth.record((long long)ioWaitingQueue.size());
+    }
+    if (!settings.frequencyLevels.empty())
+        governFrequency();
+    long long sliceStart = globalClock;
+    long long runStart = currentProc->runCycles;
+    // run the pre-instantiated slice loop for the current observers and options
+    switch ((observed() ? 1 : 0) | (settings.ioInterrupts ? 2 : 0)) {
+        case 0: runSlice<EnginePolicy<false, false> >(currentProc); break;
+        case 1: runSlice<EnginePolicy<true, false> >(currentProc); break;
+        case 2: runSlice<EnginePolicy<false, true> >(currentProc); break;
+        default: runSlice<EnginePolicy<true, true> >(currentProc); break;
+    }
+    if (settings.schedulingPolicy == SCHEDULE_STRIDE) {
+        long long ran = max(1LL, currentProc->runCycles - runStart);
+        currentProc->pass += ran * STRIDE_SCALE / currentProc->tickets;
+    }
+    if (!settings.frequencyLevels.empty()) {
+        busyTime += globalClock - sliceStart;
+        busyEnergy += (globalClock - sliceStart) * levelPower(settings.frequencyLevels[frequencyLevel]);
+    }
+    publish(stats.clock, globalClock);
+    publish(stats.readyDepth, (long long)readyCount());
+    publish(stats.ioWaitingDepth, (long long)ioWaitingQueue.size());
+
+    if (finished()) {
+        reportTotal();
+        return false;
+    }
+    return true;
+}
+
+// DVFS governor, run as a process is dispatched: step the frequency up while
+// other processes are waiting to run, and down while the CPU would otherwise
+// only serve processes that are mostly waiting for I/O
+void Simulator::governFrequency() {
+    int level = frequencyLevel;
+    if (readyCount() > 0)
+        level = min(level + 1, (int)settings.frequencyLevels.size() - 1);
+    else if (!ioWaitingQueue.empty())
+        level = max(level - 1, 0);
+    if (level != frequencyLevel) {
+        frequencyLevel = level;
+        emit(LOG_FREQUENCY, NULL, -1, settings.frequencyLevels[level]);
+    }
+}
+
+// Take the process to dispatch: the front of the ready queue under round
+// robin, otherwise the highest priority one after moving the processes that
+// became ready since the last dispatch into the heap
+PCB* Simulator::dequeueReady() {
+    // processes the heap or the lottery still hold from another policy go back
+    // in front of the queue, in the order that policy would have dispatched them
+    if (settings.schedulingPolicy != SCHEDULE_LOTTERY && !lotteryReady.empty()) {
+        for (size_t i = processes.size(); i-- > 0;) {
+            if (lotteryReady.held((int)i) > 0) {
+                lotteryReady.add((int)i, -processes[i]->tickets, -1);
+                readyQueue.push_front(processes[i]);
+            }
+        }
+    }
+    bool heapUnused = settings.schedulingPolicy == SCHEDULE_RR || settings.schedulingPolicy == SCHEDULE_LOTTERY;
+    if (heapUnused && !readyHeap.empty()) {
+        vector<PCB*> held;
+        for (; !readyHeap.empty(); readyHeap.pop())
+            held.push_back(readyHeap.top().process);
+        readyQueue.insert(readyQueue.begin(), held.begin(), held.end());
+    }
+    if (settings.schedulingPolicy == SCHEDULE_RR) {
+        if (settings.groupScheduling && readyQueue.front()->groupID != activeGroup)
+            gatherGroup();
+        PCB* next = readyQueue.front();
+        readyQueue.pop_front();
+        return next;
+    }
+    if (settings.schedulingPolicy == SCHEDULE_LOTTERY) {
+        lotteryReady.resize(processes.size());
+        for (size_t i = 0; i < readyQueue.size(); i++)
+            lotteryReady.add(readyQueue[i]->slot, readyQueue[i]->tickets, 1);
+        readyQueue.clear();
+        int winner = lotteryReady.find((long long)lottery.below((unsigned long long)lotteryReady.total()));
+        lotteryReady.add(winner, -processes[winner]->tickets, -1);
+        return processes[winner];
+    }
+    for (size_t i = 0; i < readyQueue.size(); i++) {
+        PCB* p = readyQueue[i];
+        long long key;
+        if (settings.schedulingPolicy == SCHEDULE_STRIDE) {
+            p->pass = max(p->pass, globalPass);  // no credit for time spent waiting
+            key = p->pass;
+        } else {
+            key = settings.schedulingPolicy == SCHEDULE_EDF ? p->deadline : p->period;
+            key = key > 0 ? key : LLONG_MAX;
+        }
+        ReadyEntry entry = { key, readyOrder++, p };
+        readyHeap.push(entry);
+    }
+    readyQueue.clear();
+    PCB* next = readyHeap.top().process;
+    readyHeap.pop();
+    globalPass = next->pass;
+    return next;
+}
+
+// Measure CPU shares up to now, the first termination: after it the
+// remaining processes compete for the whole CPU
+void Simulator::closeShareWindow() {
+    shareWindowEnd = globalClock;
+    for (size_t i = 0; i < processes.size(); i++)
+        processes[i]->shareCycles = processes[i]->runningTimeStart >= 0 ? processes[i]->runCycles : -1;
+}
+
+// A group member reached the front of the ready queue: move the group's other
+// ready members, in queue order, right behind it
+void Simulator::gatherGroup() {
+    activeGroup = readyQueue.front()->groupID;
+    if (activeGroup != 0)
+        stable_partition(readyQueue.begin() + 1, readyQueue.end(),
+                         [this](const PCB* p) { return p->groupID == activeGroup; });
+}
+
+// Move the clock forward during a slice; with ioInterrupts every I/O release
+// passed on the way is handled at its own time
+template <class Policy>
+void Simulator::advanceClock(long long cycles) {
+    if (!Policy::ioInterrupts || globalClock + cycles < nextIoRelease) {
+        addCycles(globalClock, cycles);
+        return;
+    }
+    long long target = globalClock;
+    addCycles(target, cycles);
+    while (nextIoRelease <= target) {
+        globalClock = max(globalClock, nextIoRelease);
+        ioQueueCheck();
+        ioInterrupted = true;
+    }
+    globalClock = target;
+}
+
+// Cycles of a STORE or LOAD of a word of process: 1 without the cache model,
+// otherwise the hit or miss cost, counted against the process
+inline long long Simulator::memoryCost(PCB& process, int address) {
+    if (!cache.enabled())
+        return 1;
+    if (cache.access(process.mainMemoryBase + address)) {
+        process.cacheHits++;
+        return settings.cacheHitCycles;
+    }
+    process.cacheMisses++;
+    return settings.cacheMissCycles;
+}
+
+// Ticks a COMPUTE of the given nominal cycles takes at the current frequency, rounded up
+inline long long Simulator::computeTime(int cycles) const {
+    if (settings.frequencyLevels.empty())
+        return cycles;
+    long long percent = settings.frequencyLevels[frequencyLevel];
+    return ((long long)cycles * 100 + percent - 1) / percent;
+}
+
+// Events of a slice; variants that nobody observes compile them out
+template <class Policy>
+void Simulator::trace(int type, const PCB* process, int instruction, long long value) {
+    if (Policy::observed)
+        emit(type, process, instruction, value);
+}
+
+void Simulator::runUntil(long long time) {
+    while (globalClock < time && step()) {}
+}
+
+void Simulator::run() {
+    while (step()) {}
+}
+
+// Run one time slice of currentProc and move it to the queue it ends up in
+template <class Policy>
+void Simulator::runSlice(PCB* currentProc) {
+    preemptingReady = 0;
+    advanceClock<Policy>(settings.contextSwitchTime); // add in context switch time
+    ioInterrupted = false;
+    trace<Policy>(LOG_RUNNING, currentProc, (*currentProc).currentInstructionIndex, (*currentProc).mainMemoryBase);
+    if (Policy::observed && histograms != NULL)
+        histograms->readyWait.record(globalClock - (*currentProc).queuedSince);
+
+    // Record start time if this is the first time the process is scheduled
+    if ((*currentProc).runningTimeStart == -1) (*currentProc).runningTimeStart = globalClock;
+
+    long long sliceCycles = 0; // Tracks the number of CPU cycles used within the current time slice
+    bool ioOccurred = false;   // Flag to indicate if an I/O operation occurred during execution
+    bool blocked = false;      // A SEND or RECV is waiting on its mailbox
+    bool timeoutOccurred = false; // Flag to indicate if the process has reached its time slice limit
+    bool preempted = false;       // An I/O completion preempted the process (ioPreemption)
+    bool headerSynced = true;  // Whether the header in mainMemory matches the running PCB
+    int executed = 0;          // instructions run in this slice
+
+    // Execute until the time expires or an I/O event comes in
+    while ((*currentProc).remainingInstructions > 0 && sliceCycles < (*currentProc).CPUAllocated) {
+        int instrIndex = (*currentProc).currentInstructionIndex;
+        const vector<int>& instr = (*(*currentProc).jobOperations)[instrIndex];
+        int instrType = instr[0];
+        headerSynced = false;
+        executed++;
+
+        // if instruction is COMPUTE
+        if (instrType == COMPUTE) {
+            // the process is charged the nominal cycles, the slice and clock the scaled ticks
+            long long cost = computeTime(instr[2]);
+            addCycles(sliceCycles, cost);
+            addCycles((*currentProc).cpuCyclesUsed, instr[2]);
+            advanceClock<Policy>(cost);
+            trace<Policy>(LOG_COMPUTE, currentProc, instrIndex, cost);
+            (*currentProc).currentInstructionIndex++;
+            (*currentProc).remainingInstructions--;
+            if (sliceCycles >= (*currentProc).CPUAllocated)
+                timeoutOccurred = true;
+        }
+        // if instruction is PRINT
+        else if (instrType == PRINT) {
+            int printCycles = instr[1];
+            addCycles((*currentProc).cpuCyclesUsed, printCycles);
+            (*currentProc).pendingPrint = true;
+            (*currentProc).ioReleaseTime = globalClock;
+            addCycles((*currentProc).ioReleaseTime, printCycles);
+            trace<Policy>(LOG_IO_ISSUED, currentProc, instrIndex, printCycles);
+            (*currentProc).currentInstructionIndex++;
+            (*currentProc).remainingInstructions--;
+            ioOccurred = true;
+            break;
+        }
+        // if instruction is STORE
+        else if (instrType == STORE || instrType == STORE_UNCHECKED || instrType == STORE_FAULT) {
+            int value = instr[1];
+            int address = instr[2];
+            bool inBounds = operandInBounds<Policy::checked>(instrType, STORE_UNCHECKED, STORE_FAULT,
+                                                             *currentProc, address, mainMemory.size());
+            long long cost = inBounds ? memoryCost(*currentProc, address) : 1;
+            addCycles(sliceCycles, cost);
+            addCycles((*currentProc).cpuCyclesUsed, cost);
+            advanceClock<Policy>(cost);
+            if (inBounds) {
+                // a store into the process's own header must land on top of the saved context
+                bool intoHeader = address >= 0 && address < PCB_HEADER_WORDS;
+                if (intoHeader)
+                    writeBackHeader(*currentProc, mainMemory);
+                mainMemory.set((*currentProc).mainMemoryBase + address, value);
+                (*currentProc).registerValue = value;
+                if (intoHeader) {
+                    mainMemory.set((*currentProc).mainMemoryBase + 7, value);
+                    mainMemory.set((*currentProc).mainMemoryBase + 2, instrIndex + 1);
+                    headerSynced = true;
+                }
+                trace<Policy>(LOG_STORED, currentProc, instrIndex, value);
+            } else {
+                trace<Policy>(LOG_STORE_ERROR, currentProc, instrIndex, address);
+            }
+            (*currentProc).currentInstructionIndex++;
+            (*currentProc).remainingInstructions--;
+            if (sliceCycles >= (*currentProc).CPUAllocated)
+                timeoutOccurred = true;
+        }
+        // if instruction is LOAD
+        else if (instrType == LOAD || instrType == LOAD_UNCHECKED || instrType == LOAD_FAULT) {
+            int offset = instr[1];
+            bool inBounds = operandInBounds<Policy::checked>(instrType, LOAD_UNCHECKED, LOAD_FAULT,
+                                                             *currentProc, offset, mainMemory.size());
+            long long cost = inBounds ? memoryCost(*currentProc, offset) : 1;
+            addCycles(sliceCycles, cost);
+            addCycles((*currentProc).cpuCyclesUsed, cost);
+            advanceClock<Policy>(cost);
+            if (inBounds) {
+                // a load from the process's own header must see the current context
+                if (offset >= 0 && offset < PCB_HEADER_WORDS)
+                    writeBackHeader(*currentProc, mainMemory);
+                (*currentProc).registerValue = mainMemory[(*currentProc).mainMemoryBase + offset];
+                trace<Policy>(LOG_LOADED, currentProc, instrIndex, (*currentProc).registerValue);
+            } else {
+                (*currentProc).registerValue = -1;
+                trace<Policy>(LOG_LOAD_ERROR, currentProc, instrIndex, offset);
+            }
+            (*currentProc).currentInstructionIndex++;
+            (*currentProc).remainingInstructions--;
+            if (sliceCycles >= (*currentProc).CPUAllocated)
+                timeoutOccurred = true;
+        }
+        // if instruction is ADD or SUB, on the register; wraps like the hardware would
+        else if (instrType == ADD || instrType == SUB) {
+            addCycles(sliceCycles, 1);
+            addCycles((*currentProc).cpuCyclesUsed, 1);
+            advanceClock<Policy>(1);
+            unsigned operand = (unsigned)instr[1];
+            unsigned reg = (unsigned)(*currentProc).registerValue;
+            (*currentProc).registerValue = (int)(instrType == ADD ? reg + operand : reg - operand);
+            trace<Policy>(instrType == ADD ? LOG_ADDED : LOG_SUBTRACTED, currentProc, instrIndex, (*currentProc).registerValue);
+            (*currentProc).currentInstructionIndex++;
+            (*currentProc).remainingInstructions--;
+            if (sliceCycles >= (*currentProc).CPUAllocated)
+                timeoutOccurred = true;
+        }
+        // if instruction is JUMP or BRANCH, the loader checked the target is within the job
+        else if (instrType == JUMP || instrType == BRANCH) {
+            addCycles(sliceCycles, 1);
+            addCycles((*currentProc).cpuCyclesUsed, 1);
+            advanceClock<Policy>(1);
+            bool taken = instrType == JUMP || (*currentProc).registerValue != 0;
+            int next = taken ? instr[1] : instrIndex + 1;
+            if (instrType == JUMP)
+                trace<Policy>(LOG_JUMPED, currentProc, instrIndex, next);
+            else
+                trace<Policy>(LOG_BRANCHED, currentProc, instrIndex, taken ? 1 : 0);
+            (*currentProc).currentInstructionIndex = next;
+            (*currentProc).remainingInstructions = (int)(*currentProc).jobOperations->size() - next;
+            if (sliceCycles >= (*currentProc).CPUAllocated)
+                timeoutOccurred = true;
+        }
+        // if instruction is SEND or RECV, the process stays on it while it is blocked
+        else if (instrType == SEND || instrType == RECV) {
+            addCycles(sliceCycles, 1);
+            addCycles((*currentProc).cpuCyclesUsed, 1);
+            advanceClock<Policy>(1);
+            if (!(instrType == SEND ? sendMessage(currentProc, instr[1]) : receiveMessage(currentProc, instr[1]))) {
+                blocked = true;
+                break;
+            }
+            (*currentProc).currentInstructionIndex++;
+            (*currentProc).remainingInstructions--;
+            if (sliceCycles >= (*currentProc).CPUAllocated)
+                timeoutOccurred = true;
+        }
+        // if instruction is HALT, the process ends here
+        else if (instrType == HALT) {
+            trace<Policy>(LOG_HALTED, currentProc, instrIndex, 0);
+            (*currentProc).currentInstructionIndex++;
+            (*currentProc).remainingInstructions = 0;
+        }
+
+        // a process woken by an interrupt runs next
+        if (Policy::ioInterrupts && ioInterrupted && settings.ioPreemption && !timeoutOccurred) {
+            preempted = true;
+            break;
+        }
+    }
+
+    // save the context at the end of the slice, as a context switch would
+    if (!headerSynced)
+        writeBackHeader(*currentProc, mainMemory);
+    bump(stats.instructions, executed);
+    (*currentProc).runCycles += sliceCycles;
+    if (Policy::observed && histograms != NULL && (*currentProc).CPUAllocated > 0)
+        histograms->sliceUtilization.record(sliceCycles * 100 / (*currentProc).CPUAllocated);
+    (*currentProc).queuedSince = globalClock;
+
+    // check if any more instructions are left, if io push to ioWaitingQueue, if timeout push to readyQueue
+    if ((*currentProc).remainingInstructions > 0) {
+        if (ioOccurred) {
+            ioWaitingQueue.push(currentProc);
+            ioQueueCheck();
+        }
+        else if (blocked) {
+            // waits in its mailbox until another process's RECV or SEND completes it
+            ioQueueCheck();
+        }
+        else if (timeoutOccurred) {
+            trace<Policy>(LOG_TIMEOUT, currentProc, (*currentProc).currentInstructionIndex, 0);
+            readyQueue.push_back(currentProc);
+            ioQueueCheck();
+        }
+        else if (preempted) {
+            trace<Policy>(LOG_PREEMPTED, currentProc, (*currentProc).currentInstructionIndex, 0);
+            readyQueue.push_back(currentProc);
+        }
+        else {
+            trace<Policy>(LOG_ERROR, currentProc, (*currentProc).currentInstructionIndex, 0);
+            readyQueue.push_back(currentProc);
+        }
+    }
+    else {
+        terminate(currentProc);
+    }
+}
+
+// SEND the register of sender to a mailbox: hand it to a blocked receiver, queue it,
+// or block while the mailbox is full; false when blocked
+bool Simulator::sendMessage(PCB* sender, int mailboxID) {
+    Mailbox& box = mailboxes[mailboxID];
+    int instrIndex = sender->currentInstructionIndex;
+    if (box.blockedReceivers.empty() && (long long)box.messages.size() >= box.capacity) {
+        box.blockedSenders.push_back(sender);
+        box.blockedSends++;
+        sender->state = MSGWAITING;
+        sender->queuedSince = globalClock;
+        emit(LOG_SEND_BLOCKED, sender, instrIndex, mailboxID);
+        return false;
+    }
+    box.sent++;
+    emit(LOG_SENT, sender, instrIndex, mailboxID);
+    if (!box.blockedReceivers.empty()) {
+        PCB* receiver = box.blockedReceivers.front();
+        box.blockedReceivers.pop_front();
+        receiver->registerValue = sender->registerValue;
+        box.received++;
+        unblock(receiver, mailboxID, box, false);
+    } else {
+        box.messages.push_back(sender->registerValue);
+        box.peakLength = max(box.peakLength, (long long)box.messages.size());
+    }
+    if (histograms != NULL)
+        histograms->mailboxLength.record((long long)box.messages.size());
+    return true;
+}
+
+// RECV the oldest message of a mailbox into the register of receiver, refilling
+// the mailbox from a blocked sender; false when blocked on an empty mailbox
+bool Simulator::receiveMessage(PCB* receiver, int mailboxID) {
+    Mailbox& box = mailboxes[mailboxID];
+    int instrIndex = receiver->currentInstructionIndex;
+    if (box.messages.empty() && box.blockedSenders.empty()) {
+        box.blockedReceivers.push_back(receiver);
+        box.blockedReceives++;
+        receiver->state = MSGWAITING;
+        receiver->queuedSince = globalClock;
+        emit(LOG_RECV_BLOCKED, receiver, instrIndex, mailboxID);
+        return false;
+    }
+    PCB* sender = NULL;
+    if (!box.blockedSenders.empty()) {
+        sender = box.blockedSenders.front();
+        box.blockedSenders.pop_front();
+        box.sent++;
+    }
+    if (box.messages.empty()) {
+        receiver->registerValue = sender->registerValue;  // capacity 0: a direct handoff
+    } else {
+        receiver->registerValue = box.messages.front();
+        box.messages.pop_front();
+        if (sender != NULL)
+            box.messages.push_back(sender->registerValue);  // behind the ones already queued
+    }
+    box.received++;
+    emit(LOG_RECEIVED, receiver, instrIndex, mailboxID);
+    if (sender != NULL)
+        unblock(sender, mailboxID, box, true);
+    if (histograms != NULL)
+        histograms->mailboxLength.record((long long)box.messages.size());
+    return true;
+}
+
+// Complete the SEND or RECV a process was blocked on and make it ready
+void Simulator::unblock(PCB* process, int mailboxID, Mailbox& box, bool wasSending) {
+    long long waited = globalClock - process->queuedSince;
+    (wasSending ? box.sendBlockedCycles : box.receiveBlockedCycles) += waited;
+    if (histograms != NULL)
+        histograms->messageBlocking.record(waited);
+    emit(LOG_UNBLOCKED, process, process->currentInstructionIndex, mailboxID);
+    process->currentInstructionIndex++;
+    process->remainingInstructions--;
+    writeBackHeader(*process, mainMemory);
+    process->state = READY;
+    process->queuedSince = globalClock;
+    readyQueue.push_back(process);
+}
+
+// Report a finished process and record its termination time
+void Simulator::terminate(PCB* currentProc) {
+    long long pc = (*currentProc).mainMemoryBase + 9;
+    mainMemory.set((*currentProc).mainMemoryBase + 2, (int)pc);
+    (*currentProc).terminationTime = globalClock;
+    (*currentProc).state = TERMINATED;
+    bool proportional = settings.schedulingPolicy == SCHEDULE_STRIDE || settings.schedulingPolicy == SCHEDULE_LOTTERY;
+    if (proportional && shareWindowEnd < 0)
+        closeShareWindow();
+
+    long long pcbWords[LOG_PCB_WORDS] = { pc, (*currentProc).instructionBase, (*currentProc).dataBase,
+                                    (*currentProc).memoryLimit, (*currentProc).cpuCyclesUsed,
+                                    (*currentProc).registerValue, (*currentProc).maxMemoryNeeded,
+                                    (*currentProc).mainMemoryBase, (*currentProc).runningTimeStart };
+    emit(LOG_TERMINATED, currentProc, (*currentProc).currentInstructionIndex, LOG_PCB_INTS, pcbWords);
+    if (cache.enabled()) {
+        long long cacheWords[LOG_CACHE_WORDS] = { (*currentProc).cacheHits, (*currentProc).cacheMisses };
+        emit(LOG_CACHE, currentProc, (*currentProc).currentInstructionIndex, LOG_CACHE_INTS, cacheWords);
+    }
+
+    // add in final termination time
+    terminations[(*currentProc).processID] = (*currentProc).terminationTime;
+    bump(stats.terminated);
+
+    // a deadline is met if the process terminates by it
+    if ((*currentProc).deadline > 0) {
+        long long late = globalClock - (*currentProc).deadline;
+        deadlineJobs++;
+        if (late > 0) {
+            deadlineMisses++;
+            latenessTotal += late;
+            latenessMax = max(latenessMax, late);
+            if (histograms != NULL)
+                histograms->lateness.record(late);
+            emit(LOG_DEADLINE_MISSED, currentProc, -1, late);
+        }
+    }
+
+    // its memory can take the jobs waiting for admission
+    releaseMemory((*currentProc).mainMemoryBase, regionWords(*currentProc));
+    if (!admissionQueue.empty())
+        admitJobs();
+
+    // the last member to finish completes its group
+    if ((*currentProc).groupID != 0) {
+        const vector<PCB*>& members = processGroups[(*currentProc).groupID];
+        long long firstStart = LLONG_MAX;
+        bool done = true;
+        for (size_t i = 0; i < members.size() && done; i++) {
+            done = members[i]->state == TERMINATED;
+            firstStart = min(firstStart, members[i]->runningTimeStart);
+        }
+        if (done) {
+            LogRecord record = { LOG_GROUP_DONE, (*currentProc).groupID, -1, 0, globalClock, firstStart };
+            emitRecord(record, NULL);
+        }
+    }
+    ioQueueCheck();
+}
+
+// total CPU time used by all processes
+void Simulator::reportTotal() {
+    if (totalReported)
+        return;
+    totalReported = true;
+    long long stillBlocked = 0;
+    for (map<int,Mailbox>::const_iterator it = mailboxes.begin(); it != mailboxes.end(); ++it)
+        stillBlocked += (long long)(it->second.blockedSenders.size() + it->second.blockedReceivers.size());
+    if (stillBlocked > 0)
+        emit(LOG_DEADLOCK, NULL, -1, stillBlocked);
+    for (size_t i = 0; i < arrivals.size(); i++)
+        reject(arrivals[i], REJECT_UNPLACED);
+    arrivals.clear();
+    for (map<pair<long long,int>,PCB*>::const_iterator it = admissionQueue.begin(); it != admissionQueue.end(); ++it)
+        reject(it->second, REJECT_UNPLACED);
+    admissionQueue.clear();
+    publish(stats.admissionWaiting, 0);
+    if (admissionWaited > 0 || admissionRejected > 0) {
+        long long words[LOG_ADMISSION_WORDS] = { admissionWaited, admissionRejected, admissionDelayTotal,
+                                                 admissionDelayMax };
+        LogRecord record = { LOG_ADMISSION, 0, -1, 0, globalClock, LOG_ADMISSION_INTS };
+        emitRecord(record, NULL, words);
+    }
+    if (settings.schedulingPolicy == SCHEDULE_STRIDE || settings.schedulingPolicy == SCHEDULE_LOTTERY) {
+        if (shareWindowEnd < 0)
+            closeShareWindow();
+        long long allTickets = 0, allCycles = 0;
+        for (size_t i = 0; i < processes.size(); i++) {
+            if (processes[i]->shareCycles >= 0) {
+                allTickets += processes[i]->tickets;
+                allCycles += processes[i]->shareCycles;
+            }
+        }
+        for (size_t i = 0; i < processes.size(); i++) {
+            const PCB& p = *processes[i];
+            if (p.shareCycles < 0)
+                continue;
+            long long words[LOG_SHARE_WORDS] = { p.tickets, allTickets, p.shareCycles, allCycles, shareWindowEnd };
+            LogRecord record = { LOG_SHARE, p.processID, -1, 0, globalClock, LOG_SHARE_INTS };
+            emitRecord(record, &p, words);
+        }
+    }
+    // a job that never finished (rejected, never admitted or left blocked) did not meet its deadline either
+    long long unfinished = 0;
+    for (size_t i = 0; i < processes.size(); i++)
+        if (processes[i]->deadline > 0 && processes[i]->state != TERMINATED)
+            unfinished++;
+    if (deadlineJobs + unfinished > 0) {
+        long long words[LOG_DEADLINE_WORDS] = { deadlineJobs + unfinished, deadlineMisses, latenessTotal, latenessMax,
+                                                unfinished };
+        LogRecord record = { LOG_DEADLINES, 0, -1, 0, globalClock, LOG_DEADLINE_INTS };
+        emitRecord(record, NULL, words);
+    }
+    for (map<int,Mailbox>::const_iterator it = mailboxes.begin(); it != mailboxes.end(); ++it) {
+        const Mailbox& box = it->second;
+        long long words[LOG_MAILBOX_WORDS] = { box.capacity, box.sent, box.received, box.peakLength, box.blockedSends,
+                                               box.sendBlockedCycles, box.blockedReceives, box.receiveBlockedCycles };
+        LogRecord record = { LOG_MAILBOX, it->first, -1, 0, globalClock, LOG_MAILBOX_INTS };
+        emitRecord(record, NULL, words);
+    }
+    if (cache.enabled()) {
+        long long words[LOG_CACHE_WORDS] = { 0, 0 };
+        for (size_t i = 0; i < processes.size(); i++) {
+            words[0] += processes[i]->cacheHits;
+            words[1] += processes[i]->cacheMisses;
+        }
+        LogRecord record = { LOG_CACHE_TOTAL, 0, -1, 0, globalClock, LOG_CACHE_INTS };
+        emitRecord(record, NULL, words);
+    }
+
+    long long total = globalClock;
+    addCycles(total, settings.contextSwitchTime);
+    if (!settings.frequencyLevels.empty()) {
+        long long words[LOG_ENERGY_WORDS] = { busyEnergy + (total - busyTime) * IDLE_POWER, total };
+        LogRecord record = { LOG_ENERGY, 0, -1, 0, globalClock, LOG_ENERGY_INTS };
+        emitRecord(record, NULL, words);
+    }
+    emit(LOG_TOTAL, NULL, -1, total);
+    if (output != NULL)
+        output->flush();
+    if (eventLog != NULL)
+        fflush(eventLog);
+}
+
+// part of whole as a percentage to a tenth of a percent
+static void writePercent(ostream& out, long long part, long long whole) {
+    long long permille = whole > 0 ? (part * 1000 + whole / 2) / whole : 0;
+    out << permille / 10 << '.' << permille % 10 << '%';
+}
+
+// Hit and miss counts with the hit rate to a tenth of a percent
+static void writeHitRate(ostream& out, long long hits, long long misses) {
+    out << hits << " hits, " << misses << " misses";
+    if (hits + misses > 0) {
+        out << ", hit rate ";
+        writePercent(out, hits, hits + misses);
+    }
+    out << ".\n";
+}
+
+// A count of thousandths with three decimals
+static void writeThousandths(ostream& out, long long value) {
+    char digits[8];
+    snprintf(digits, sizeof(digits), "%03lld", value % 1000);
+    out << value / 1000 << '.' << digits;
+}
+
+void writeEventText(ostream& out, const LogRecord& r, const long long* w) {
+    switch (r.type) {
+        case LOG_RUNNING:
+            out << "Process " << r.processID << " has moved to Running.\n";
+            break;
+        case LOG_COMPUTE:
+            out << "compute\n";
+            break;
+        case LOG_IO_ISSUED:
+            out << "Process " << r.processID << " issued an IOInterrupt and moved to the IOWaitingQueue.\n";
+            break;
+        case LOG_STORED:
+            out << "stored\n";
+            break;
+        case LOG_STORE_ERROR:
+            out << "stored\nstore error!\n";
+            break;
+        case LOG_LOADED:
+            out << "loaded\n";
+            break;
+        case LOG_LOAD_ERROR:
+            out << "loaded\nload error!\n";
+            break;
+        case LOG_IO_COMPLETED:
+            out << "print\nProcess " << r.processID << " completed I/O and is moved to the ReadyQueue.\n";
+            break;
+        case LOG_TIMEOUT:
+            out << "Process " << r.processID << " has a TimeOUT interrupt and is moved to the ReadyQueue.\n";
+            break;
+        case LOG_ERROR:
+            out << "ERROR\n";
+            break;
+        case LOG_TERMINATED: {
+            long long totalCyclesConsumed = r.time - w[8];
+            out << "Process ID: " << r.processID << '\n'
+                << "State: TERMINATED\n"
+                << "Program Counter: " << w[0] << '\n'
+                << "Instruction Base: " << w[1] << '\n'
+                << "Data Base: " << w[2] << '\n'
+                << "Memory Limit: " << w[3] << '\n'
+                << "CPU Cycles Used: " << w[4] << '\n'
+                << "Register Value: " << w[5] << '\n'
+                << "Max Memory Needed: " << w[6] << '\n'
+                << "Main Memory Base: " << w[7] << '\n'
+                << "Total CPU Cycles Consumed: " << totalCyclesConsumed << '\n'
+                << "Process " << r.processID << " terminated. Entered running state at: " << w[8]
+                << ". Terminated at: " << r.time << ". Total Execution Time: " << totalCyclesConsumed << ".\n";
+            break;
+        }
+        case LOG_TOTAL:
+            out << "Total CPU time used: " << r.value << ".\n";
+            break;
+        case LOG_PREEMPTED:
+            out << "Process " << r.processID << " is preempted by an I/O interrupt and is moved to the ReadyQueue.\n";
+            break;
+        case LOG_ADDED:
+            out << "added\n";
+            break;
+        case LOG_SUBTRACTED:
+            out << "subtracted\n";
+            break;
+        case LOG_JUMPED:
+            out << "jumped\n";
+            break;
+        case LOG_BRANCHED:
+            out << (r.value != 0 ? "branched\n" : "not branched\n");
+            break;
+        case LOG_HALTED:
+            out << "halted\n";
+            break;
+        case LOG_SENT:
+            out << "sent\n";
+            break;
+        case LOG_RECEIVED:
+            out << "received\n";
+            break;
+        case LOG_SEND_BLOCKED:
+            out << "Process " << r.processID << " blocked sending to mailbox " << r.value
+                << " and moved to the MessageWaitingQueue.\n";
+            break;
+        case LOG_RECV_BLOCKED:
+            out << "Process " << r.processID << " blocked receiving from mailbox " << r.value
+                << " and moved to the MessageWaitingQueue.\n";
+            break;
+        case LOG_UNBLOCKED:
+            out << "Process " << r.processID << " completed its message operation on mailbox " << r.value
+                << " and is moved to the ReadyQueue.\n";
+            break;
+        case LOG_DEADLOCK:
+            out << "Deadlock: " << r.value << " processes are still blocked on mailboxes.\n";
+            break;
+        case LOG_MAILBOX:
+            out << "Mailbox " << r.processID << ": capacity " << w[0] << ", " << w[1] << " sent, " << w[2]
+                << " received, peak length " << w[3] << ", " << w[4] << " blocked sends (" << w[5] << " cycles), "
+                << w[6] << " blocked receives (" << w[7] << " cycles).\n";
+            break;
+        case LOG_CACHE:
+            out << "Process " << r.processID << " cache: ";
+            writeHitRate(out, w[0], w[1]);
+            break;
+        case LOG_CACHE_TOTAL:
+            out << "Cache: ";
+            writeHitRate(out, w[0], w[1]);
+            break;
+        case LOG_FREQUENCY:
+            out << "CPU frequency set to " << r.value << "% of nominal.\n";
+            break;
+        case LOG_ENERGY: {
+            long long product;
+            out << "Total energy used: ";
+            writeThousandths(out, w[0]);
+            out << " units. Energy-delay product: ";
+            if (__builtin_mul_overflow(w[0], w[1], &product))
+                out << (double)w[0] * w[1] / 1000;
+            else
+                writeThousandths(out, product);
+            out << ".\n";
+            break;
+        }
+        case LOG_ADMISSION_WAIT:
+            out << "Process " << r.processID << " needs " << r.value
+                << " words, does not fit in memory and waits for admission.\n";
+            break;
+        case LOG_ADMITTED:
+            out << "Process " << r.processID << " is admitted to memory after waiting " << r.value
+                << " cycles and is moved to the ReadyQueue.\n";
+            break;
+        case LOG_REJECTED:
+            out << "Process " << r.processID << " is rejected: "
+                << (r.value == REJECT_TOO_LARGE ? "it needs more memory than there is.\n" :
+                    r.value == REJECT_QUEUE_FULL ? "the admission queue is full.\n" :
+                    "it was never admitted.\n");
+            break;
+        case LOG_ADMISSION:
+            out << "Admission: " << w[0] << " jobs waited for memory (mean wait ";
+            writeThousandths(out, w[0] > 0 ? w[2] * 1000 / w[0] : 0);
+            out << " cycles, longest " << w[3] << " cycles), " << w[1] << " rejected.\n";
+            break;
+        case LOG_DEADLINE_MISSED:
+            out << "Process " << r.processID << " missed its deadline " << r.time - r.value << " by " << r.value
+                << " cycles.\n";
+            break;
+        case LOG_DEADLINES:
+            out << "Deadlines: " << w[0] - w[1] - w[4] << " of " << w[0] << " met, " << w[1] << " missed (mean lateness ";
+            writeThousandths(out, w[1] > 0 ? w[2] * 1000 / w[1] : 0);
+            out << " cycles, largest " << w[3] << " cycles)";
+            if (w[4] > 0)
+                out << ", " << w[4] << " never finished";
+            out << ".\n";
+            break;
+        case LOG_SHARE:
+            out << "Process " << r.processID << " share: " << w[0] << " of " << w[1] << " tickets (";
+            writePercent(out, w[0], w[1]);
+            out << "), " << w[2] << " of " << w[3] << " cycles (";
+            writePercent(out, w[2], w[3]);
+            out << ") up to the first termination at " << w[4] << ".\n";
+            break;
+        case LOG_GROUP_DONE:
+            out << "Group " << r.processID << " completed at " << r.time << ". Makespan: " << r.time - r.value
+                << " (first member entered running state at " << r.value << ").\n";
+            break;
+    }
+}
+
+bool Simulator::openEventLog(const char* path, bool withMemory) {
+    closeEventLog();
+    eventLog = fopen(path, "wb");
+    if (eventLog == NULL)
+        return false;
+    setvbuf(eventLog, NULL, _IOFBF, 1 << 20);
+    int memorySize = withMemory && mainMemory.size() <= INT_MAX ? (int)mainMemory.size() : 0;
+    int header[] = { LOG_MAGIC, LOG_VERSION, memorySize };
+    fwrite(header, sizeof(header), 1, eventLog);
+    vector<int> words(SimulatedMemory::CHUNK_WORDS);
+    for (long long c = 0; memorySize > 0 && c < mainMemory.chunks(); c++) {
+        mainMemory.readChunk(c, words.data());
+        fwrite(words.data(), sizeof(int), mainMemory.chunkWords(c), eventLog);
+    }
+    return true;
+}
+
+void Simulator::closeEventLog() {
+    if (eventLog != NULL)
+        fclose(eventLog);
+    eventLog = NULL;
+}
+
+// Read-only mapping of an event log file, unmapped when it goes out of scope
+struct MappedLog {
+    const int* words;  // whole file as ints
+    size_t count;      // number of ints in the file
+    size_t events;     // index of the first event record
+    size_t mappedSize; // bytes mapped, nonzero once mapEventLog mapped the file
+
+    MappedLog() : words(NULL), count(0), events(0), mappedSize(0) {}
+    ~MappedLog() {
+        if (mappedSize != 0)
+            munmap((void*)words, mappedSize);
+    }
+
+private:
+    MappedLog(const MappedLog&);
+    MappedLog& operator=(const MappedLog&);
+};
+
+// Map an event log and validate its header
+static bool mapEventLog(const char* path, MappedLog& log) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < (off_t)(3 * sizeof(int))) {
+        close(fd);
+        return false;
+    }
+    void* data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return false;
+    madvise(data, info.st_size, MADV_SEQUENTIAL);
+    log.words = (const int*)data;
+    log.mappedSize = info.st_size;
+    log.count = info.st_size / sizeof(int);
+    log.events = 3 + (size_t)log.words[2];
+    return log.words[0] == LOG_MAGIC && log.words[1] == LOG_VERSION && log.events <= log.count;
+}
+
+const size_t LOG_RECORD_INTS = sizeof(LogRecord) / sizeof(int);
+
+// Copy out the record starting at words[pos]; records are only 4-byte aligned in the file
+static inline LogRecord readRecord(const int* words, size_t pos) {
+    LogRecord record;
+    memcpy(&record, words + pos, sizeof(record));
+    return record;
+}
+
+// Number of ints taken by the record starting at words[pos]
+static inline size_t recordWords(const int* words, size_t pos) {
+    LogRecord record = readRecord(words, pos);
+    bool trailer = record.type == LOG_TERMINATED || record.type == LOG_MAILBOX || record.type == LOG_CACHE ||
+                   record.type == LOG_CACHE_TOTAL || record.type == LOG_ENERGY || record.type == LOG_ADMISSION ||
+                   record.type == LOG_DEADLINES || record.type == LOG_SHARE;
+    return trailer ? LOG_RECORD_INTS + record.value : LOG_RECORD_INTS;
+}
+
+bool expandEventLog(const char* path, ostream& out) {
+    MappedLog log;
+    if (!mapEventLog(path, log))
+        return false;
+    for (size_t i = 3; i < log.events; i++)
+        out << i - 3 << " : " << log.words[i] << '\n';
+    for (size_t pos = log.events; pos + LOG_RECORD_INTS <= log.count; pos += recordWords(log.words, pos)) {
+        long long pcbWords[max(LOG_PCB_WORDS, LOG_MAILBOX_WORDS)] = {};
+        LogRecord r = readRecord(log.words, pos);
+        size_t trailer = recordWords(log.words, pos) - LOG_RECORD_INTS;
+        if (pos + LOG_RECORD_INTS + trailer <= log.count && trailer * sizeof(int) <= sizeof(pcbWords))
+            memcpy(pcbWords, log.words + pos + LOG_RECORD_INTS, trailer * sizeof(int));
+        writeEventText(out, r, pcbWords);
+    }
+    out.flush();
+    return true;
+}
+
+bool diffEventLogs(const char* pathA, const char* pathB, ostream& out) {
+    MappedLog a, b;
+    if (!mapEventLog(pathA, a) || !mapEventLog(pathB, b)) {
+        cerr << "Unable to read event logs " << pathA << " and " << pathB << endl;
+        return false;
+    }
+
+    // find the first differing int with large memcmp blocks, then walk records up to it
+    size_t common = min(a.count, b.count);
+    size_t diff = common;
+    const size_t block = 1 << 18;
+    for (size_t i = 0; i < common; i += block) {
+        size_t n = min(block, common - i);
+        if (memcmp(a.words + i, b.words + i, n * sizeof(int)) != 0) {
+            while (a.words[i] == b.words[i])
+                i++;
+            diff = i;
+            break;
+        }
+    }
+    if (diff == common && a.count == b.count) {
+        out << "Event logs are identical." << endl;
+        return true;
+    }
+    if (diff < max(a.events, b.events)) {
+        out << "Initial memory images differ at address " << (diff < 3 ? 0 : diff - 3) << "." << endl;
+        return false;
+    }
+
+    size_t eventIndex = 0;
+    size_t pos = a.events;
+    for (size_t next; pos < common && (next = pos + recordWords(a.words, pos)) <= diff; pos = next)
+        eventIndex++;
+    if (pos + LOG_RECORD_INTS > a.count || pos + LOG_RECORD_INTS > b.count) {
+        out << "Event logs match for " << eventIndex << " events, then "
+            << (a.count < b.count ? pathA : pathB) << " ends." << endl;
+        return false;
+    }
+    LogRecord ra = readRecord(a.words, pos);
+    LogRecord rb = readRecord(b.words, pos);
+    out << "First divergent event " << eventIndex << ":" << endl;
+    out << pathA << ": time " << ra.time << ", process " << ra.processID << ", instruction " << ra.instruction
+        << ", type " << ra.type << ", value " << ra.value << endl;
+    out << pathB << ": time " << rb.time << ", process " << rb.processID << ", instruction " << rb.instruction
+        << ", type " << rb.type << ", value " << rb.value << endl;
+    return false;
+}
+
+// Checkpoint file layout (native-endian):
+// int magic, version, contextSwitchTime, then long long globalClock, memory
+// size and number of written chunks, each chunk as its long long index
+// followed by its words (unwritten chunks read -1 and are left out), then the
+// length of the packed state followed by the packed programs, PCBs (referring
+// to programs by index), both queues (as indexes into processes) and the
+// termination map, the active group, the mailboxes, the cache lines and the
+// DVFS level and energy so far, and the admission state: free memory,
+// arrivals, the admission queue and its statistics, then the scheduling
+// policy, the EDF/RMS ready heap in priority order and the deadline
+// statistics, then the lottery (ready slots, seed and generator state) and
+// the stride and share window state.
+const int CHECKPOINT_VERSION = 14;
+
+// Append a program to out
+static void packProgram(const Program& program, vector<int>& out) {
+    out.push_back((int)program.size());
+    for (size_t i = 0; i < program.size(); i++) {
+        out.push_back((int)program[i].size());
+        out.insert(out.end(), program[i].begin(), program[i].end());
+    }
+}
+
+// Cursor over the packed state of a checkpoint. The server restores images its
+// clients send, so nothing in them is trusted: a read past the end or a value
+// that fails validation makes ok() false, and every later read returns 0.
+class StateReader {
+public:
+    explicit StateReader(const vector<int>& state) : in(state), pos(0), failed(false) {}
+
+    bool ok() const { return !failed; }
+    void fail() { failed = true; }
+
+    int next() {
+        if (failed || pos >= in.size()) {
+            failed = true;
+            return 0;
+        }
+        return in[pos++];
+    }
+
+    // A 64-bit field packed by packWide
+    long long wide() {
+        unsigned long long low = (unsigned)next();
+        return (long long)(low | (unsigned long long)(unsigned)next() << 32);
+    }
+
+    // The number of items that follow, each at least itemWords ints long, so a
+    // corrupt count fails here instead of allocating more than the image holds
+    int count(size_t itemWords) {
+        int n = next();
+        if (n < 0 || (size_t)n > (in.size() - pos) / itemWords) {
+            failed = true;
+            return 0;
+        }
+        return n;
+    }
+
+    // An index into a table of size entries
+    int index(size_t size) {
+        int i = next();
+        if (i < 0 || (size_t)i >= size) {
+            failed = true;
+            return 0;
+        }
+        return i;
+    }
+
+private:
+    const vector<int>& in;
+    size_t pos;
+    bool failed;
+};
+
+// Whether runSlice can execute instr in a program of programSize instructions:
+// a known opcode (or decoded form) with its operands, and a target within the program
+static bool validInstruction(const vector<int>& instr, size_t programSize) {
+    if (instr.empty())
+        return false;
+    switch (instr[0]) {
+        case COMPUTE:
+        case STORE:
+        case STORE_UNCHECKED:
+        case STORE_FAULT:
+            return instr.size() == 3;
+        case PRINT:
+        case LOAD:
+        case LOAD_UNCHECKED:
+        case LOAD_FAULT:
+        case ADD:
+        case SUB:
+            return instr.size() == 2;
+        case JUMP:
+        case BRANCH:
+            return instr.size() == 2 && instr[1] >= 0 && (size_t)instr[1] <= programSize;
+        case SEND:
+        case RECV:
+            return instr.size() == 2 && instr[1] >= 0;
+        case HALT:
+            return instr.size() == 1;
+    }
+    return false;
+}
+
+// Read a program written by packProgram, false if it is not one runSlice can execute
+static bool unpackProgram(StateReader& in, Program& program) {
+    int numOperations = in.count(1);
+    program.assign(numOperations, vector<int>());
+    for (int i = 0; i < numOperations && in.ok(); i++) {
+        int size = in.count(1);
+        program[i].reserve(size);
+        for (int j = 0; j < size; j++)
+            program[i].push_back(in.next());
+        if (!validInstruction(program[i], program.size()))
+            in.fail();
+    }
+    return in.ok();
+}
+
+// Append a 64-bit field as its low and high ints
+static inline void packWide(long long value, vector<int>& out) {
+    out.push_back((int)value);
+    out.push_back((int)(value >> 32));
+}
+
+// Append every PCB field to out, with its operations as an index into the packed programs
+static void packPCB(const PCB& p, int programIndex, vector<int>& out) {
+    out.push_back(p.processID);
+    out.push_back(p.state);
+    out.push_back(p.programCounter);
+    packWide(p.instructionBase, out);
+    packWide(p.dataBase, out);
+    out.push_back(p.memoryLimit);
+    packWide(p.cpuCyclesUsed, out);
+    out.push_back(p.registerValue);
+    out.push_back(p.maxMemoryNeeded);
+    packWide(p.mainMemoryBase, out);
+    out.push_back(p.CPUAllocated);
+    out.push_back(p.groupID);
+    packWide(p.deadline, out);
+    packWide(p.period, out);
+    out.push_back(p.tickets);
+    packWide(p.pass, out);
+    packWide(p.runCycles, out);
+    packWide(p.shareCycles, out);
+    packWide(p.runningTimeStart, out);
+    packWide(p.terminationTime, out);
+    out.push_back(p.currentInstructionIndex);
+    out.push_back(p.remainingInstructions);
+    packWide(p.ioReleaseTime, out);
+    packWide(p.queuedSince, out);
+    packWide(p.cacheHits, out);
+    packWide(p.cacheMisses, out);
+    out.push_back(p.pendingPrint ? 1 : 0);
+    out.push_back(programIndex);
+}
+
+// Read a PCB written by packPCB, false if its program index is not in programs
+static bool unpackPCB(StateReader& in, const vector<shared_ptr<const Program> >& programs, PCB& p) {
+    p.processID = in.next();
+    p.state = in.next();
+    p.programCounter = in.next();
+    p.instructionBase = in.wide();
+    p.dataBase = in.wide();
+    p.memoryLimit = in.next();
+    p.cpuCyclesUsed = in.wide();
+    p.registerValue = in.next();
+    p.maxMemoryNeeded = in.next();
+    p.mainMemoryBase = in.wide();
+    p.CPUAllocated = in.next();
+    p.groupID = in.next();
+    p.deadline = in.wide();
+    p.period = in.wide();
+    p.tickets = in.next();
+    p.pass = in.wide();
+    p.runCycles = in.wide();
+    p.shareCycles = in.wide();
+    p.runningTimeStart = in.wide();
+    p.terminationTime = in.wide();
+    p.currentInstructionIndex = in.next();
+    p.remainingInstructions = in.next();
+    p.ioReleaseTime = in.wide();
+    p.queuedSince = in.wide();
+    p.cacheHits = in.wide();
+    p.cacheMisses = in.wide();
+    p.pendingPrint = in.next() != 0;
+    int programIndex = in.index(programs.size());
+    if (in.ok())
+        p.jobOperations = programs[programIndex];
+    return in.ok();
+}
+
+// Whether a restored process keeps to what runSlice assumes: a time slice and
+// tickets to divide by, an instruction index within its program, and once it is placed, a header
+// and unchecked STORE/LOAD operands inside main memory
+static bool validProcess(const PCB& p, long long memorySize) {
+    long long size = (long long)p.jobOperations->size();
+    if (p.CPUAllocated <= 0 || p.tickets <= 0 || p.currentInstructionIndex < 0 || p.currentInstructionIndex > size ||
+        p.remainingInstructions < 0 ||
+        (p.remainingInstructions > 0 && p.currentInstructionIndex + p.remainingInstructions != size))
+        return false;
+    if (p.mainMemoryBase == -1)
+        return true;
+    if (p.mainMemoryBase < 0 || p.mainMemoryBase > memorySize - PCB_HEADER_WORDS)
+        return false;
+    for (long long i = 0; i < size; i++) {
+        const vector<int>& instr = (*p.jobOperations)[i];
+        if (instr[0] != STORE_UNCHECKED && instr[0] != LOAD_UNCHECKED)
+            continue;
+        int address = instr[0] == STORE_UNCHECKED ? instr[2] : instr[1];
+        if (address >= p.memoryLimit ||
+            (unsigned long long)(p.mainMemoryBase + address) >= (unsigned long long)memorySize)
+            return false;
+    }
+    return true;
+}
+
+
+
+bool Simulator::saveCheckpoint(const char* path) const {
+    FILE* file = fopen(path, "wb");
+    if (file == NULL)
+        return false;
+
+    map<PCB*,int> processIndex;
+    for (size_t i = 0; i < processes.size(); i++)
+        processIndex[processes[i]] = (int)i;
+
+    // shared programs are written once
+    map<const Program*,int> programIndex;
+    vector<const Program*> programs;
+    for (size_t i = 0; i < processes.size(); i++) {
+        const Program* program = processes[i]->jobOperations.get();
+        if (programIndex.insert(make_pair(program, (int)programs.size())).second)
+            programs.push_back(program);
+    }
+
+    // everything but mainMemory is packed into one buffer so it goes out in a single write
+    vector<int> state;
+    state.push_back((int)programs.size());
+    for (size_t i = 0; i < programs.size(); i++)
+        packProgram(*programs[i], state);
+    state.push_back((int)processes.size());
+    for (size_t i = 0; i < processes.size(); i++)
+        packPCB(*processes[i], programIndex[processes[i]->jobOperations.get()], state);
+    state.push_back((int)readyQueue.size());
+    for (size_t i = 0; i < readyQueue.size(); i++)
+        state.push_back(processIndex[readyQueue[i]]);
+    queue<PCB*> ioWaiting = ioWaitingQueue;
+    state.push_back((int)ioWaiting.size());
+    for (; !ioWaiting.empty(); ioWaiting.pop())
+        state.push_back(processIndex[ioWaiting.front()]);
+    state.push_back((int)terminations.size());
+    for (map<int,long long>::const_iterator it = terminations.begin(); it != terminations.end(); ++it) {
+        state.push_back(it->first);
+        packWide(it->second, state);
+    }
+    state.push_back(activeGroup);
+    state.push_back((int)mailboxes.size());
+    for (map<int,Mailbox>::const_iterator it = mailboxes.begin(); it != mailboxes.end(); ++it) {
+        const Mailbox& box = it->second;
+        state.push_back(it->first);
+        state.push_back(box.capacity);
+        state.push_back((int)box.messages.size());
+        state.insert(state.end(), box.messages.begin(), box.messages.end());
+        state.push_back((int)box.blockedSenders.size());
+        for (size_t i = 0; i < box.blockedSenders.size(); i++)
+            state.push_back(processIndex[box.blockedSenders[i]]);
+        state.push_back((int)box.blockedReceivers.size());
+        for (size_t i = 0; i < box.blockedReceivers.size(); i++)
+            state.push_back(processIndex[box.blockedReceivers[i]]);
+        long long counters[] = { box.sent, box.received, box.peakLength, box.blockedSends, box.sendBlockedCycles,
+                                 box.blockedReceives, box.receiveBlockedCycles };
+        for (size_t i = 0; i < sizeof(counters) / sizeof(counters[0]); i++)
+            packWide(counters[i], state);
+    }
+    state.push_back((int)cache.tags.size());
+    for (size_t i = 0; i < cache.tags.size(); i++) {
+        packWide(cache.tags[i], state);
+        packWide((long long)cache.lastUse[i], state);
+    }
+    packWide((long long)cache.tick, state);
+    state.push_back(frequencyLevel);
+    packWide(busyTime, state);
+    packWide(busyEnergy, state);
+    state.push_back((int)freeMemory.size());
+    for (map<long long,long long>::const_iterator it = freeMemory.begin(); it != freeMemory.end(); ++it) {
+        packWide(it->first, state);
+        packWide(it->second, state);
+    }
+    state.push_back((int)arrivals.size());
+    for (size_t i = 0; i < arrivals.size(); i++)
+        state.push_back(processIndex[arrivals[i]]);
+    state.push_back((int)admissionQueue.size());
+    for (map<pair<long long,int>,PCB*>::const_iterator it = admissionQueue.begin(); it != admissionQueue.end(); ++it) {
+        packWide(it->first.first, state);
+        state.push_back(it->first.second);
+        state.push_back(processIndex[it->second]);
+    }
+    long long admission[] = { admissionWaited, admissionRejected, admissionDelayTotal, admissionDelayMax };
+    for (size_t i = 0; i < sizeof(admission) / sizeof(admission[0]); i++)
+        packWide(admission[i], state);
+    state.push_back(settings.schedulingPolicy);
+    vector<ReadyEntry> heap = readyHeap.values();
+    sort(heap.begin(), heap.end());
+    state.push_back((int)heap.size());
+    for (size_t i = 0; i < heap.size(); i++) {
+        packWide(heap[i].key, state);
+        packWide(heap[i].order, state);
+        state.push_back(processIndex[heap[i].process]);
+    }
+    long long deadlines[] = { readyOrder, deadlineJobs, deadlineMisses, latenessTotal, latenessMax };
+    for (size_t i = 0; i < sizeof(deadlines) / sizeof(deadlines[0]); i++)
+        packWide(deadlines[i], state);
+    vector<int> lotterySlots;
+    for (size_t i = 0; i < processes.size() && !lotteryReady.empty(); i++)
+        if (lotteryReady.held((int)i) > 0)
+            lotterySlots.push_back((int)i);
+    state.push_back((int)lotterySlots.size());
+    state.insert(state.end(), lotterySlots.begin(), lotterySlots.end());
+    packWide((long long)settings.lotterySeed, state);
+    for (int i = 0; i < 4; i++)
+        packWide((long long)lottery.state[i], state);
+    packWide(globalPass, state);
+    packWide(shareWindowEnd, state);
+
+    int header[] = { CHECKPOINT_MAGIC, CHECKPOINT_VERSION, settings.contextSwitchTime };
+    long long wideHeader[] = { globalClock, mainMemory.size(), 0 };
+    for (long long c = 0; c < mainMemory.chunks(); c++)
+        wideHeader[2] += mainMemory.chunkWritten(c);
+    bool ok = fwrite(header, sizeof(header), 1, file) == 1 &&
+              fwrite(wideHeader, sizeof(wideHeader), 1, file) == 1;
+    vector<int> words(SimulatedMemory::CHUNK_WORDS);
+    for (long long c = 0; ok && c < mainMemory.chunks(); c++) {
+        if (!mainMemory.chunkWritten(c))
+            continue;
+        size_t n = mainMemory.chunkWords(c);
+        mainMemory.readChunk(c, words.data());
+        ok = fwrite(&c, sizeof(c), 1, file) == 1 && fwrite(words.data(), sizeof(int), n, file) == n;
+    }
+    long long stateSize = (long long)state.size();
+    ok = ok && fwrite(&stateSize, sizeof(stateSize), 1, file) == 1 &&
+         fwrite(state.data(), sizeof(int), state.size(), file) == state.size();
+    return fclose(file) == 0 && ok;
+}
+
+bool Simulator::loadCheckpoint(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL)
+        return false;
+    vector<char> image;
+    char chunk[1 << 16];
+    for (size_t n; (n = fread(chunk, 1, sizeof(chunk), file)) > 0;)
+        image.insert(image.end(), chunk, chunk + n);
+    fclose(file);
+    return restoreCheckpoint(image.data(), image.size());
+}
+
+bool Simulator::restoreCheckpoint(const char* data, size_t size) {
+    reset();
+    int header[3];
+    long long wideHeader[3];
+    long long stateSize = 0;
+    size_t pos = sizeof(header) + sizeof(wideHeader);
+    if (size < pos)
+        return false;
+    memcpy(header, data, sizeof(header));
+    memcpy(wideHeader, data + sizeof(header), sizeof(wideHeader));
+    if (header[0] != CHECKPOINT_MAGIC || header[1] != CHECKPOINT_VERSION || wideHeader[1] < 0 ||
+        !mainMemory.assign(wideHeader[1]))
+        return false;
+    settings.contextSwitchTime = header[2];
+    globalClock = wideHeader[0];
+    settings.maxMemory = wideHeader[1];
+    vector<int> words(SimulatedMemory::CHUNK_WORDS);
+    for (long long i = 0; i < wideHeader[2]; i++) {
+        long long chunk;
+        if (size - pos < sizeof(chunk))
+            return false;
+        memcpy(&chunk, data + pos, sizeof(chunk));
+        pos += sizeof(chunk);
+        if (chunk < 0 || chunk >= mainMemory.chunks())
+            return false;
+        size_t bytes = mainMemory.chunkWords(chunk) * sizeof(int);
+        if (size - pos < bytes)
+            return false;
+        memcpy(words.data(), data + pos, bytes);
+        pos += bytes;
+        mainMemory.write(chunk * SimulatedMemory::CHUNK_WORDS, words.data(), mainMemory.chunkWords(chunk));
+    }
+    if (size - pos < sizeof(stateSize))
+        return false;
+    memcpy(&stateSize, data + pos, sizeof(stateSize));
+    pos += sizeof(stateSize);
+    if (stateSize < 0 || (size - pos) / sizeof(int) < (size_t)stateSize)
+        return false;
+    vector<int> state(stateSize);
+    memcpy(state.data(), data + pos, state.size() * sizeof(int));
+
+    StateReader in(state);
+    int numPrograms = in.count(1);
+    vector<shared_ptr<const Program> > programs;
+    for (int i = 0; i < numPrograms; i++) {
+        Program program;
+        if (!unpackProgram(in, program))
+            return false;
+        programs.push_back(programTable.intern(program));
+    }
+    int numProcesses = in.count(1);
+    for (int i = 0; i < numProcesses; i++) {
+        PCB* pProc = new PCB();
+        processes.push_back(pProc);
+        if (!unpackPCB(in, programs, *pProc) || !validProcess(*pProc, mainMemory.size()))
+            return false;
+        pProc->slot = i;
+    }
+    if (!processes.empty())
+        settings.CPUAllocated = processes[0]->CPUAllocated;
+
+    // a process in a queue, a mailbox or the ready heap has been placed in memory
+    auto placedProcess = [&in, this]() -> PCB* {
+        int i = in.index(processes.size());
+        if (!in.ok() || processes[i]->mainMemoryBase < 0) {
+            in.fail();
+            return NULL;
+        }
+        return processes[i];
+    };
+    int readyCount = in.count(1);
+    for (int i = 0; i < readyCount; i++) {
+        PCB* p = placedProcess();
+        if (p == NULL)
+            return false;
+        readyQueue.push_back(p);
+    }
+    int ioCount = in.count(1);
+    for (int i = 0; i < ioCount; i++) {
+        PCB* p = placedProcess();
+        if (p == NULL)
+            return false;
+        ioWaitingQueue.push(p);
+        nextIoRelease = min(nextIoRelease, p->ioReleaseTime);
+    }
+    int terminatedCount = in.count(3);
+    for (int i = 0; i < terminatedCount; i++) {
+        int pid = in.next();
+        terminations[pid] = in.wide();
+    }
+    activeGroup = in.next();
+    int mailboxCount = in.count(5);
+    for (int i = 0; i < mailboxCount; i++) {
+        int mailboxID = in.next();
+        Mailbox& box = mailboxes[mailboxID];
+        box.capacity = in.next();
+        if (mailboxID < 0 || box.capacity < 0)
+            return false;
+        int messageCount = in.count(1);
+        for (int j = 0; j < messageCount; j++)
+            box.messages.push_back(in.next());
+        int senderCount = in.count(1);
+        for (int j = 0; j < senderCount; j++) {
+            PCB* p = placedProcess();
+            if (p == NULL)
+                return false;
+            box.blockedSenders.push_back(p);
+        }
+        int receiverCount = in.count(1);
+        for (int j = 0; j < receiverCount; j++) {
+            PCB* p = placedProcess();
+            if (p == NULL)
+                return false;
+            box.blockedReceivers.push_back(p);
+        }
+        long long* counters[] = { &box.sent, &box.received, &box.peakLength, &box.blockedSends,
+                                  &box.sendBlockedCycles, &box.blockedReceives, &box.receiveBlockedCycles };
+        for (size_t j = 0; j < sizeof(counters) / sizeof(counters[0]); j++)
+            *counters[j] = in.wide();
+    }
+    // the cache geometry comes from the configuration and has to match
+    if (in.next() != (int)cache.tags.size())
+        return false;
+    for (size_t i = 0; i < cache.tags.size(); i++) {
+        cache.tags[i] = in.wide();
+        cache.lastUse[i] = (unsigned long long)in.wide();
+    }
+    cache.tick = (unsigned long long)in.wide();
+    frequencyLevel = in.next();
+    if (frequencyLevel < 0 || frequencyLevel >= max(1, (int)settings.frequencyLevels.size()))
+        return false;
+    busyTime = in.wide();
+    busyEnergy = in.wide();
+    int freeCount = in.count(4);
+    for (int i = 0; i < freeCount; i++) {
+        long long base = in.wide();
+        long long words = in.wide();
+        if (base < 0 || words <= 0 || base > mainMemory.size() - words)
+            return false;
+        freeMemory[base] = words;
+    }
+    int arrivalCount = in.count(1);
+    for (int i = 0; i < arrivalCount; i++) {
+        int index = in.index(processes.size());
+        if (!in.ok())
+            return false;
+        arrivals.push_back(processes[index]);
+    }
+    int waitingCount = in.count(4);
+    for (int i = 0; i < waitingCount; i++) {
+        long long key = in.wide();
+        int order = in.next();
+        int index = in.index(processes.size());
+        if (!in.ok())
+            return false;
+        admissionQueue[make_pair(key, order)] = processes[index];
+    }
+    long long* admission[] = { &admissionWaited, &admissionRejected, &admissionDelayTotal, &admissionDelayMax };
+    for (size_t i = 0; i < sizeof(admission) / sizeof(admission[0]); i++)
+        *admission[i] = in.wide();
+    // the ready heap only makes sense under the policy that built it
+    int policy = in.next();
+    if (policy < SCHEDULE_RR || policy > SCHEDULE_LOTTERY)
+        return false;
+    settings.schedulingPolicy = (SchedulingPolicy)policy;
+    int heapCount = in.count(5);
+    for (int i = 0; i < heapCount; i++) {
+        ReadyEntry entry;
+        entry.key = in.wide();
+        entry.order = in.wide();
+        entry.process = placedProcess();
+        if (entry.process == NULL)
+            return false;
+        readyHeap.push(entry);
+    }
+    long long* deadlines[] = { &readyOrder, &deadlineJobs, &deadlineMisses, &latenessTotal, &latenessMax };
+    for (size_t i = 0; i < sizeof(deadlines) / sizeof(deadlines[0]); i++)
+        *deadlines[i] = in.wide();
+    int lotteryCount = in.count(1);
+    lotteryReady.resize(processes.size());
+    for (int i = 0; i < lotteryCount; i++) {
+        PCB* p = placedProcess();
+        if (p == NULL || lotteryReady.held(p->slot) > 0)
+            return false;
+        lotteryReady.add(p->slot, p->tickets, 1);
+    }
+    settings.lotterySeed = (unsigned long long)in.wide();
+    for (int i = 0; i < 4; i++)
+        lottery.state[i] = (unsigned long long)in.wide();
+    globalPass = in.wide();
+    shareWindowEnd = in.wide();
+    if (!in.ok())
+        return false;
+    for (size_t i = 0; i < processes.size(); i++)
+        if (processes[i]->groupID != 0)
+            processGroups[processes[i]->groupID].push_back(processes[i]);
+    publishTotals();
+    return true;
+}
+
+void TicketTree::resize(size_t slots) {
+    if (slots + 1 <= tree.size())
+        return;
+    vector<long long> held(tree.size() - 1);
+    for (size_t i = 0; i < held.size(); i++)
+        held[i] = this->held((int)i);
+    tree.assign(slots + 1, 0);
+    long long kept = members;
+    for (size_t i = 0; i < held.size(); i++)
+        if (held[i] != 0)
+            add((int)i, held[i], 0);
+    members = kept;
+}
+
+void CacheModel::configure(long long sizeWords, int ways, int lineWords) {
+    this->ways = ways;
+    this->lineWords = lineWords;
+    bool usable = sizeWords > 0 && ways > 0 && lineWords > 0 && sizeWords % ((long long)ways * lineWords) == 0;
+    sets = usable ? sizeWords / ((long long)ways * lineWords) : 0;
+    flush();
+}
+
+void CacheModel::flush() {
+    tags.assign((size_t)(sets * ways), -1);
+    lastUse.assign(tags.size(), 0);
+    tick = 0;
+}
+
+// Buckets 0..63 hold their value; after that each power of two [2^k, 2^(k+1))
+// is split into SUB_BUCKETS equal buckets by the 5 bits below the leading one
+int Histogram::bucketOf(long long value) {
+    if (value < LINEAR_BUCKETS)
+        return (int)value;
+    int shift = 63 - __builtin_clzll(value) - 5;
+    return LINEAR_BUCKETS + (shift - 1) * SUB_BUCKETS + (int)(value >> shift) - SUB_BUCKETS;
+}
+
+long long Histogram::bucketHigh(int bucket) {
+    if (bucket < LINEAR_BUCKETS)
+        return bucket;
+    int shift = (bucket - LINEAR_BUCKETS) / SUB_BUCKETS + 1;
+    unsigned long long top = (bucket - LINEAR_BUCKETS) % SUB_BUCKETS + SUB_BUCKETS + 1;
+    return (long long)((top << shift) - 1);
+}
+
+void Histogram::record(long long value) {
+    if (value < 0)
+        value = 0;
+    counts[bucketOf(value)].fetch_add(1, memory_order_relaxed);
+    total.fetch_add(1, memory_order_relaxed);
+    sum.fetch_add(value, memory_order_relaxed);
+    long long seen = minimum.load(memory_order_relaxed);
+    while (value < seen && !minimum.compare_exchange_weak(seen, value, memory_order_relaxed)) {}
+    seen = maximum.load(memory_order_relaxed);
+    while (value > seen && !maximum.compare_exchange_weak(seen, value, memory_order_relaxed)) {}
+}
+
+void Histogram::clear() {
+    for (int i = 0; i < BUCKETS; i++)
+        counts[i].store(0, memory_order_relaxed);
+    total.store(0, memory_order_relaxed);
+    sum.store(0, memory_order_relaxed);
+    minimum.store(LLONG_MAX, memory_order_relaxed);
+    maximum.store(0, memory_order_relaxed);
+}
+
+long long Histogram::percentile(double percent) const {
+    long long samples = count();
+    if (samples == 0)
+        return 0;
+    long long rank = std::max(1LL, (long long)ceil(percent / 100 * samples));
+    long long seen = 0;
+    for (int i = 0; i < BUCKETS; i++) {
+        seen += counts[i].load(memory_order_relaxed);
+        if (seen >= rank)
+            return std::min(bucketHigh(i), max());
+    }
+    return max();
+}
+
+void SchedulerHistograms::clear() {
+    readyDepth.clear();
+    ioWaitingDepth.clear();
+    readyWait.clear();
+    ioLatency.clear();
+    ioDelay.clear();
+    mailboxLength.clear();
+    messageBlocking.clear();
+    admissionDelay.clear();
+    lateness.clear();
+    sliceUtilization.clear();
+}
+
+void SchedulerHistograms::print(ostream& out) const {
+    static const double percents[] = { 50, 90, 99, 99.9, 99.99 };
+    const Histogram* rows[] = { &readyDepth, &ioWaitingDepth, &readyWait, &ioLatency, &ioDelay, &sliceUtilization,
+                                &mailboxLength, &messageBlocking, &admissionDelay, &lateness };
+    const char* names[] = { "ready queue length", "I/O queue length", "ready wait (cycles)",
+                            "I/O latency (cycles)", "I/O delay (cycles)", "slice utilization (%)",
+                            "mailbox length", "message wait (cycles)", "admission wait (cycles)",
+                            "lateness (cycles)" };
+    ostringstream table;
+    table << left << setw(24) << "histogram" << right << setw(12) << "count" << setw(10) << "min";
+    for (double p : percents) {
+        ostringstream label;
+        label << 'p' << p;
+        table << setw(10) << label.str();
+    }
+    table << setw(10) << "max" << setw(12) << "mean" << '\n';
+    for (size_t r = 0; r < sizeof(rows) / sizeof(rows[0]); r++) {
+        const Histogram& h = *rows[r];
+        table << left << setw(24) << names[r] << right << setw(12) << h.count() << setw(10) << h.min();
+        for (double p : percents)
+            table << setw(10) << h.percentile(p);
+        table << setw(10) << h.max() << setw(12) << fixed << setprecision(2) << h.mean() << '\n';
+    }
+    out << table.str() << flush;
+}
+
+ProgressMonitor::ProgressMonitor(const SimulatorStats& stats, ostream& out, int intervalMs) :
+    stats(stats), out(out), intervalMs(max(1, intervalMs)),
+    firstInstructions(stats.instructions.load(memory_order_relaxed)), lastClock(stats.clock.load(memory_order_relaxed)),
+    stopping(false), sampler(&ProgressMonitor::sampleLoop, this) {}
+
+ProgressMonitor::~ProgressMonitor() {
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_one();
+    sampler.join();
+}
+
+void ProgressMonitor::sampleLoop() {
+    typedef chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+    Clock::time_point last = start;
+    unique_lock<mutex> guard(lock);
+    for (bool done = false; !done;) {
+        done = wake.wait_for(guard, chrono::milliseconds(intervalMs), [this]() { return stopping; });
+        Clock::time_point now = Clock::now();
+        printSample(chrono::duration<double>(now - start).count(), chrono::duration<double>(now - last).count());
+        last = now;
+    }
+}
+
+// One line: clock and cycle rate since the last line, then progress and ETA
+void ProgressMonitor::printSample(double elapsed, double interval) {
+    long long clock = stats.clock.load(memory_order_relaxed);
+    long long executed = stats.instructions.load(memory_order_relaxed);
+    long long total = stats.totalInstructions.load(memory_order_relaxed);
+
+    ostringstream line;
+    line << fixed << setprecision(1) << "[progress " << elapsed << "s] clock " << clock;
+    if (interval > 0)
+        line << " (" << (clock - lastClock) / interval / 1e6 << "M cycles/s)";
+    line << ", instructions " << executed << "/" << total;
+    bool looped = executed > total;  // programs with loops run more than their static length
+    if (total > 0 && !looped)
+        line << " (" << 100.0 * executed / total << "%)";
+    line << ", dispatches " << stats.dispatches.load(memory_order_relaxed)
+         << ", I/O completions " << stats.ioCompletions.load(memory_order_relaxed)
+         << ", ready " << stats.readyDepth.load(memory_order_relaxed)
+         << ", I/O waiting " << stats.ioWaitingDepth.load(memory_order_relaxed)
+         << ", terminated " << stats.terminated.load(memory_order_relaxed)
+         << "/" << stats.jobs.load(memory_order_relaxed);
+    if (!looped && executed > firstInstructions && elapsed > 0)
+        line << ", ETA " << (total - executed) * elapsed / (executed - firstInstructions) << "s";
+    line << '\n';
+    out << line.str() << flush;
+    lastClock = clock;
+}
@@ -0,0 +1,1089 @@
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+/*
+Project 2: CPU Scheduling and Memory Management
+CS 3113
+Spring 2025
+Jishan Rahman
+
+Simulator library: the scheduler and memory model behind the project2 CLI,
+usable in-process through the Simulator class.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <queue>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Process States.
+enum ProcessState {
+	NEW = 1,
+	READY,
+	RUNNING,
+	IOWAITING,
+	TERMINATED,
+	MSGWAITING };  // blocked on a SEND or RECV
+
+// Instruction opcodes as they appear in the job file
+enum InstructionType {
+	COMPUTE = 1,
+	PRINT,
+	STORE,
+	LOAD,
+	ADD,      // registerValue += operand
+	SUB,      // registerValue -= operand
+	JUMP,     // continue at the instruction index given by the operand
+	BRANCH,   // JUMP if registerValue is nonzero
+	HALT,     // terminate the process
+	SEND,     // put registerValue in the mailbox given by the operand, blocking while it is full
+	RECV };   // take the oldest message of the mailbox into registerValue, blocking while it is empty
+
+// Forms the loader rewrites STORE/LOAD into once their static operand is validated
+enum DecodedInstruction {
+	STORE_UNCHECKED = 13,
+	LOAD_UNCHECKED,
+	STORE_FAULT = 23,
+	LOAD_FAULT };
+
+// Build with -DCHECKED_BUILD to skip decoding and check every access at run time
+#ifdef CHECKED_BUILD
+const bool kCheckedBuild = true;
+#else
+const bool kCheckedBuild = false;
+#endif
+
+// Build with -DOVERFLOW_CHECKED to stop with an error when a clock or cycle
+// counter would overflow instead of wrapping
+#ifdef OVERFLOW_CHECKED
+const bool kOverflowChecked = true;
+#else
+const bool kOverflowChecked = false;
+#endif
+
+// Simulated main memory with 64-bit word addresses. The words live in an
+// anonymous mapping that the kernel commits a page at a time on first write;
+// they are stored inverted, so a page that was never written (zero filled)
+// reads as -1 and takes no host memory. Written regions are tracked in
+// CHUNK_WORDS units so dumps and checkpoints can skip the untouched ones.
+class SimulatedMemory {
+public:
+    static const long long CHUNK_WORDS = 1 << 14;
+
+    SimulatedMemory() : words(NULL), length(0), capacity(0) {}
+    ~SimulatedMemory();
+
+    // Resize to size words that all read -1, reusing the mapping when it is large enough
+    bool assign(long long size);
+
+    // Release every written page and become empty
+    void clear() { assign(0); }
+
+    long long size() const { return length; }
+
+    int operator[](long long address) const { return ~words[address]; }
+
+    void set(long long address, int value) {
+        words[address] = ~value;
+        written[address / CHUNK_WORDS] = 1;
+    }
+
+    // Store count words starting at address; words past the end are dropped
+    void write(long long address, const int* values, long long count);
+
+    // Chunks cover [chunk * CHUNK_WORDS, min(size, (chunk + 1) * CHUNK_WORDS))
+    long long chunks() const { return (long long)written.size(); }
+    bool chunkWritten(long long chunk) const { return written[chunk] != 0; }
+    long long chunkWords(long long chunk) const { return std::min(CHUNK_WORDS, length - chunk * CHUNK_WORDS); }
+
+    // Copy the words of a chunk into out (CHUNK_WORDS ints); unwritten chunks are filled with -1
+    void readChunk(long long chunk, int* out) const;
+
+private:
+    SimulatedMemory(const SimulatedMemory&);
+    SimulatedMemory& operator=(const SimulatedMemory&);
+
+    int* words;
+    long long length;
+    size_t capacity;                     // mapped bytes
+    std::vector<unsigned char> written;  // one flag per chunk
+};
+
+// Instruction stream of a job, one vector per instruction with the opcode first
+typedef std::vector<std::vector<int> > Program;
+
+// Tickets of a process without a "tickets" directive
+const int DEFAULT_TICKETS = 100;
+
+// PCB structure
+struct PCB {
+    int processID;
+    int state;            // current state of PCB
+    int programCounter;   // Stored at mainMemoryBase + 2
+    long long instructionBase;
+    long long dataBase;
+    int memoryLimit;
+    long long cpuCyclesUsed;  // total cpu cycles used, at the nominal clock; the header word holds the low 32 bits
+    int registerValue;
+    int maxMemoryNeeded; // max amount of memory needed
+    long long mainMemoryBase;  // header words hold the low 32 bits of the bases, -1 until admitted
+    std::shared_ptr<const Program> jobOperations; // read-only, shared by jobs with identical instructions
+
+    // variables needed to get infomation about the processes
+    int CPUAllocated;            // amount of time cpu is allowed
+    long long runningTimeStart;  // when process started time
+    long long terminationTime;   // when process ended time
+    int groupID;                 // process group from a "group" directive, 0 for none
+    long long deadline;          // from a "deadline" directive or load time + period, 0 for none
+    long long period;            // from a "period" directive, 0 for none
+    int tickets;                 // proportional share from a "tickets" directive
+    long long pass;              // stride scheduling: virtual time, the lowest runs next
+    long long runCycles;         // ticks spent running on the CPU, DVFS scaling included
+    long long shareCycles;       // runCycles at the first termination, -1 if it had not started by then
+    int slot;                    // index in the simulator's process list
+    int currentInstructionIndex; // where the next instruction is indexed at
+    int remainingInstructions;   // number of instructions left
+    long long ioReleaseTime;     // global clock time when I/O wait ends
+    long long queuedSince;       // when it entered the ready or I/O waiting queue
+    long long cacheHits;         // STORE/LOAD accesses that hit the cache model
+    long long cacheMisses;
+    bool pendingPrint;           // condition if a print is pending
+
+    PCB() :
+		processID(0),
+		state(NEW),
+		programCounter(0),
+		instructionBase(0),
+		dataBase(0),
+        memoryLimit(0),
+		cpuCyclesUsed(0),
+		registerValue(0),
+		maxMemoryNeeded(0),
+        mainMemoryBase(0),
+		CPUAllocated(0),
+		runningTimeStart(-1),
+		terminationTime(0),
+		groupID(0),
+		deadline(0),
+		period(0),
+		tickets(DEFAULT_TICKETS),
+		pass(0),
+		runCycles(0),
+		shareCycles(-1),
+		slot(0),
+        currentInstructionIndex(0),
+		remainingInstructions(0),
+		ioReleaseTime(0),
+		queuedSince(0),
+		cacheHits(0),
+		cacheMisses(0),
+        pendingPrint(false) {}
+};
+
+// Interns identical instruction streams so duplicate jobs share one read-only copy
+class ProgramTable {
+public:
+    // Return the shared copy of program, adding it if it has not been seen yet
+    std::shared_ptr<const Program> intern(const Program& program) {
+        std::vector<std::shared_ptr<const Program> >& bucket = programs[hashProgram(program)];
+        for (size_t i = 0; i < bucket.size(); i++)
+            if (*bucket[i] == program)
+                return bucket[i];
+        bucket.push_back(std::make_shared<const Program>(program));
+        return bucket.back();
+    }
+
+    void clear() { programs.clear(); }
+
+private:
+    // FNV-1a over every instruction word
+    static unsigned long long hashProgram(const Program& program) {
+        unsigned long long hash = 14695981039346656037ULL;
+        for (size_t i = 0; i < program.size(); i++) {
+            hash = (hash ^ (unsigned)program[i].size()) * 1099511628211ULL;
+            for (size_t j = 0; j < program[i].size(); j++)
+                hash = (hash ^ (unsigned)program[i][j]) * 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    std::unordered_map<unsigned long long, std::vector<std::shared_ptr<const Program> > > programs;
+};
+
+// Reads the whitespace separated integers of a job file. Regular files are
+// mmapped and anything else (pipes) is read into one buffer; like a stream's
+// failbit the first error is kept, here with its line and column.
+class JobReader {
+public:
+    explicit JobReader(int fd);
+
+    // Reader over a copy of size bytes of text already in memory
+    JobReader(const char* text, size_t size);
+
+    // View of [begin, limit) of another reader's input, reporting errors against its lines
+    JobReader(const JobReader& whole, const char* begin, const char* limit) :
+        data(whole.data), cur(begin), end(limit), mappedSize(0), error(NULL), errorAt(NULL), lastToken(begin) {}
+
+    ~JobReader();
+
+    // Read the next integer; after an error every read yields 0
+    JobReader& operator>>(int& value) { return readInteger(value); }
+    JobReader& operator>>(long long& value) { return readInteger(value); }
+
+    bool ok() const { return error == NULL; }
+
+    // Whether only separators are left
+    bool atEnd() {
+        while (isSeparator(*cur))
+            cur++;
+        return cur >= end;
+    }
+
+    // Continue at position, past input already parsed through views of this reader
+    void skipTo(const char* position) { cur = position; }
+
+    // Whether only separators are left on the current line
+    bool atLineEnd() {
+        while (*cur != '\n' && isSeparator(*cur))
+            cur++;
+        return *cur == '\n' || cur >= end;
+    }
+
+    const char* position() const { return cur; }
+    const char* limit() const { return end; }
+
+    // Print the first error as "line L, column C: message"; lines are only counted here
+    void printError(std::ostream& out) const;
+
+    // Read the next token as a word, for directives; false at the end of the input
+    bool readWord(std::string& word) {
+        if (atEnd() || error != NULL)
+            return false;
+        lastToken = cur;
+        while (cur < end && !isSeparator(*cur))
+            cur++;
+        word.assign(lastToken, cur);
+        return true;
+    }
+
+    // Fail at the integer or word just read, for values that parse but are not allowed there
+    void reject(const char* message) {
+        if (error == NULL)
+            fail(message, lastToken);
+    }
+
+private:
+    static const size_t PADDING = 8;
+
+    template <typename T>
+    JobReader& readInteger(T& value) {
+        value = 0;
+        if (error != NULL)
+            return *this;
+        while (isSeparator(*cur))
+            cur++;
+        if (cur >= end) {
+            fail("unexpected end of input");
+            return *this;
+        }
+        const char* token = cur;
+        lastToken = token;
+        bool negative = *cur == '-';
+        cur += negative || *cur == '+';
+        const char* digits = cur;
+        unsigned long long magnitude = scanDigits();
+        if (cur == digits || (cur < end && !isSeparator(*cur))) {
+            fail("expected an integer", token);
+        } else if (cur - digits > std::numeric_limits<T>::digits10 + 1 ||
+                   magnitude > (unsigned long long)std::numeric_limits<T>::max() + negative) {
+            fail("integer out of range", token);
+        } else {
+            value = negative ? (T)(0 - magnitude) : (T)magnitude;
+        }
+        return *this;
+    }
+
+    // Consume the digits at cur and return their value (exact for up to 19 digits)
+    unsigned long long scanDigits() {
+        unsigned long long magnitude = 0;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        // SWAR: find the first non-digit of the next 8 bytes and convert the digits
+        // before it with three multiplies, so typical short tokens take no per-digit branches
+        unsigned long long word;
+        memcpy(&word, cur, sizeof(word));
+        unsigned long long values = word ^ 0x3030303030303030ULL;  // digits become 0..9
+        unsigned long long nonDigits = ((values + 0x7676767676767676ULL) | values) & 0x8080808080808080ULL;
+        int length = nonDigits != 0 ? __builtin_ctzll(nonDigits) >> 3 : 8;
+        if (length == 0)
+            return 0;
+        values <<= 8 * (8 - length);  // leading zero digits pad the low bytes
+        values = ((values & 0x0F0F0F0F0F0F0F0FULL) * 2561) >> 8;
+        values = ((values & 0x00FF00FF00FF00FFULL) * 6553601) >> 16;
+        magnitude = ((values & 0x0000FFFF0000FFFFULL) * 42949672960001ULL) >> 32;
+        cur += length;
+        if (length < 8)
+            return magnitude;
+#endif
+        for (unsigned digit; (digit = (unsigned)(*cur - '0')) <= 9; cur++)
+            magnitude = magnitude * 10 + digit;
+        return magnitude;
+    }
+
+    // Separators are the characters isspace accepts: space, \t, \n, \v, \f and \r
+    static bool isSeparator(char c) {
+        return c == ' ' || (unsigned char)(c - '\t') <= '\r' - '\t';
+    }
+
+    void fail(const char* message, const char* at = NULL) {
+        error = message;
+        errorAt = at != NULL ? at : (cur < end ? cur : end);
+        cur = end;
+    }
+
+    JobReader(const JobReader&);
+    JobReader& operator=(const JobReader&);
+
+    const char* data;
+    const char* cur;
+    const char* end;
+    size_t mappedSize;         // nonzero when data is an mmapped file
+    std::vector<char> buffer;  // input read from a pipe, NUL padded
+    const char* error;
+    const char* errorAt;
+    const char* lastToken;     // start of the integer read last
+};
+
+// A job as read from the input, before it is laid out in memory
+struct JobRecord {
+    int processID;
+    int memoryLimit;
+    int groupID;  // 0 unless a directive puts the job in a group
+    long long deadline;  // 0 unless a directive gives one
+    long long period;
+    int tickets;  // 0 unless a directive gives them, DEFAULT_TICKETS then
+    Program operations;
+};
+
+// Read one job: process ID, memory limit, instruction count and the instructions
+void readJobRecord(JobReader& input, JobRecord& job);
+
+// Read numProcesses jobs, in parallel for large inputs written one job per line
+bool readJobRecords(JobReader& input, int numProcesses, std::vector<JobRecord>& jobs);
+
+// Read the optional directives after the jobs, one per line:
+//   group <groupID> <processID>...   the jobs form a group (groupID > 0)
+//   mailbox <mailboxID> <capacity>   capacity of a mailbox, 1 if not declared
+//   deadline <processID> <time>      the job should finish by time (> 0)
+//   period <processID> <cycles>      the job's period (> 0), its deadline if it has none
+//   tickets <processID> <count>      the job's share under stride and lottery scheduling (> 0)
+bool readJobDirectives(JobReader& input, std::vector<JobRecord>& jobs, std::map<int,int>& mailboxCapacities);
+
+// Event types, one per line (or block of lines) of the text trace
+enum LogEventType {
+    LOG_RUNNING = 1,
+    LOG_COMPUTE,
+    LOG_IO_ISSUED,
+    LOG_STORED,
+    LOG_STORE_ERROR,
+    LOG_LOADED,
+    LOG_LOAD_ERROR,
+    LOG_IO_COMPLETED,
+    LOG_TIMEOUT,
+    LOG_ERROR,
+    LOG_TERMINATED,   // followed by LOG_PCB_WORDS long longs of the final PCB
+    LOG_TOTAL,
+    LOG_PREEMPTED,    // only with SimulatorConfig::ioPreemption
+    LOG_ADDED,        // value is the new register value
+    LOG_SUBTRACTED,
+    LOG_JUMPED,       // value is the target instruction index
+    LOG_BRANCHED,     // value is 1 if the branch was taken
+    LOG_HALTED,
+    LOG_GROUP_DONE,   // processID is the group, value when its first member started
+    LOG_SENT,         // value is the mailbox
+    LOG_RECEIVED,
+    LOG_SEND_BLOCKED,
+    LOG_RECV_BLOCKED,
+    LOG_UNBLOCKED,    // a blocked SEND or RECV completed, for the process it belongs to
+    LOG_DEADLOCK,     // value is the number of processes left blocked
+    LOG_MAILBOX,      // processID is the mailbox, followed by LOG_MAILBOX_WORDS long longs
+    LOG_CACHE,        // cache hits and misses of a terminated process, in LOG_CACHE_WORDS long longs
+    LOG_CACHE_TOTAL,  // the same for the whole run, with processID 0
+    LOG_FREQUENCY,    // the DVFS governor changed the frequency, value is the new level in percent
+    LOG_ENERGY,       // energy and delay of the run, in LOG_ENERGY_WORDS long longs
+    LOG_ADMISSION_WAIT,  // a job did not fit in memory and joined the admission queue
+    LOG_ADMITTED,     // value is the cycles the job waited for admission
+    LOG_REJECTED,     // value is the AdmissionRejection
+    LOG_ADMISSION,    // admission statistics of the run, in LOG_ADMISSION_WORDS long longs
+    LOG_DEADLINE_MISSED,  // value is the lateness, the cycles past the deadline
+    LOG_DEADLINES,    // deadline statistics of the run, in LOG_DEADLINE_WORDS long longs
+    LOG_SHARE };      // requested and achieved CPU share of a process, in LOG_SHARE_WORDS long longs
+
+const int CHECKPOINT_MAGIC = 0x4b434353;  // first int of a checkpoint file
+const int LOG_MAGIC = 0x474c4353;
+const int LOG_VERSION = 4;
+const int LOG_PCB_WORDS = 9;
+const int LOG_PCB_INTS = LOG_PCB_WORDS * (int)(sizeof(long long) / sizeof(int));  // value of a LOG_TERMINATED record
+const int LOG_MAILBOX_WORDS = 8;
+const int LOG_MAILBOX_INTS = LOG_MAILBOX_WORDS * (int)(sizeof(long long) / sizeof(int));  // value of a LOG_MAILBOX record
+const int LOG_CACHE_WORDS = 2;
+const int LOG_CACHE_INTS = LOG_CACHE_WORDS * (int)(sizeof(long long) / sizeof(int));  // value of a LOG_CACHE record
+const int LOG_ENERGY_WORDS = 2;  // energy in thousandths of a unit, total time
+const int LOG_ENERGY_INTS = LOG_ENERGY_WORDS * (int)(sizeof(long long) / sizeof(int));
+const int LOG_ADMISSION_WORDS = 4;  // jobs that waited, jobs rejected, total and longest wait
+const int LOG_ADMISSION_INTS = LOG_ADMISSION_WORDS * (int)(sizeof(long long) / sizeof(int));
+const int LOG_DEADLINE_WORDS = 5;  // jobs with a deadline, jobs that missed it, total and largest lateness,
+                                   // jobs that never finished
+const int LOG_DEADLINE_INTS = LOG_DEADLINE_WORDS * (int)(sizeof(long long) / sizeof(int));
+const int LOG_SHARE_WORDS = 5;  // tickets, all tickets, cycles, all cycles, end of the measured window
+const int LOG_SHARE_INTS = LOG_SHARE_WORDS * (int)(sizeof(long long) / sizeof(int));
+
+// Why a job was turned away at admission
+enum AdmissionRejection {
+    REJECT_TOO_LARGE,   // needs more words than main memory has
+    REJECT_QUEUE_FULL,  // backpressure: the admission queue was at its limit
+    REJECT_UNPLACED };  // still waiting when the run ended
+
+// Fixed-size event record, time is the global clock after the event
+struct LogRecord {
+    int type;
+    int processID;
+    int instruction;  // index of the instruction that caused the event, -1 if none
+    int unused;       // zero, aligns time
+    long long time;
+    long long value;
+};
+
+// Write the text trace lines of one event; pcbWords holds the words that follow a
+// LOG_TERMINATED, LOG_MAILBOX, LOG_CACHE, LOG_CACHE_TOTAL, LOG_ENERGY, LOG_ADMISSION,
+// LOG_DEADLINES or LOG_SHARE record
+void writeEventText(std::ostream& out, const LogRecord& record, const long long* pcbWords);
+
+// Print an event log in the text format the simulator writes
+bool expandEventLog(const char* path, std::ostream& out);
+
+// Compare two event logs and report the first divergent event, returns true if they match
+bool diffEventLogs(const char* pathA, const char* pathB, std::ostream& out);
+
+// Which ready process is dispatched next
+enum SchedulingPolicy {
+    SCHEDULE_RR,    // round robin, the front of the ready queue
+    SCHEDULE_EDF,   // earliest deadline first, processes without one last
+    SCHEDULE_RMS,     // rate monotonic, shortest period first, processes without one last
+    SCHEDULE_STRIDE,  // proportional share: lowest pass first, the pass advances by cycles / tickets
+    SCHEDULE_LOTTERY };  // proportional share: a ready process drawn with probability tickets / ready tickets
+
+// Order in which jobs that did not fit in memory are admitted; the head of the
+// queue waits until it fits, and the jobs behind it wait with it
+enum AdmissionPolicy {
+    ADMIT_FIFO,      // in arrival order
+    ADMIT_SMALLEST,  // fewest words first
+    ADMIT_DEADLINE };  // earliest deadline first, jobs without one last
+
+// System parameters from the first line of a job file, and run options
+struct SimulatorConfig {
+    long long maxMemory;
+    int CPUAllocated;
+    int contextSwitchTime;
+
+    // Deliver each I/O completion as an interrupt at its release time, even in
+    // the middle of a slice or an instruction, instead of at slice boundaries
+    bool ioInterrupts;
+    // With ioInterrupts, a completion puts the process at the front of the
+    // ready queue and preempts the running one after its current instruction
+    bool ioPreemption;
+    // Group-aware round robin: once a group member is dispatched, the other
+    // ready members of its group are dispatched right after it
+    bool groupScheduling;
+    // Set-associative LRU cache model that decides what a STORE or LOAD
+    // costs; off while cacheWords is 0, or if it is not a multiple of
+    // cacheWays * cacheLineWords
+    long long cacheWords;
+    int cacheWays;
+    int cacheLineWords;
+    int cacheHitCycles;
+    int cacheMissCycles;
+    // DVFS frequency levels in percent of the nominal clock, ascending; empty
+    // runs at the nominal clock without an energy report. COMPUTE takes
+    // cycles * 100 / level ticks, and a governor picks the level at each dispatch.
+    std::vector<int> frequencyLevels;
+    // Jobs that do not fit in memory wait in an admission queue of at most
+    // admissionLimit jobs (0 for no limit), and are admitted in this order
+    // as terminating processes free their memory
+    AdmissionPolicy admissionPolicy;
+    int admissionLimit;
+    // EDF and RMS still run each process for a time slice at most, then
+    // dispatch the highest priority ready process, which may be the same one
+    SchedulingPolicy schedulingPolicy;
+    unsigned long long lotterySeed;  // the same seed draws the same winners
+
+    SimulatorConfig() :
+        maxMemory(0), CPUAllocated(0), contextSwitchTime(0), ioInterrupts(false), ioPreemption(false),
+        groupScheduling(false), cacheWords(0), cacheWays(4), cacheLineWords(8), cacheHitCycles(1),
+        cacheMissCycles(10), admissionPolicy(ADMIT_FIFO), admissionLimit(0), schedulingPolicy(SCHEDULE_RR),
+        lotterySeed(1) {}
+};
+
+// Event passed to hooks; process is NULL for LOG_TOTAL, LOG_GROUP_DONE, LOG_DEADLOCK, LOG_MAILBOX,
+// LOG_CACHE_TOTAL, LOG_FREQUENCY, LOG_ENERGY, LOG_ADMISSION and LOG_DEADLINES
+struct SimulatorEvent {
+    LogRecord record;
+    const PCB* process;
+    const long long* pcbWords;  // words following a record that has them, NULL otherwise
+};
+
+// A bounded message queue for SEND and RECV, with the processes blocked on it
+struct Mailbox {
+    int capacity;                       // 0 makes every SEND wait for a RECV
+    std::deque<int> messages;
+    std::deque<PCB*> blockedSenders;    // each sends its registerValue once there is room
+    std::deque<PCB*> blockedReceivers;
+
+    // reported with LOG_MAILBOX, in this order
+    long long sent;
+    long long received;
+    long long peakLength;
+    long long blockedSends;
+    long long sendBlockedCycles;
+    long long blockedReceives;
+    long long receiveBlockedCycles;
+
+    explicit Mailbox(int capacity = 1) :
+        capacity(capacity), sent(0), received(0), peakLength(0), blockedSends(0), sendBlockedCycles(0),
+        blockedReceives(0), receiveBlockedCycles(0) {}
+};
+
+// Set-associative cache with LRU replacement in front of main memory. It only
+// tracks which lines are present to price each access; the words stay in
+// main memory. Stores allocate their line like loads do.
+struct CacheModel {
+    long long sets;                       // 0 when the cache is off
+    int ways;
+    int lineWords;
+    std::vector<long long> tags;          // line held by each way, set by set; -1 if empty
+    std::vector<unsigned long long> lastUse;  // access tick of each way, 0 if empty
+    unsigned long long tick;
+
+    CacheModel() : sets(0), ways(0), lineWords(0), tick(0) {}
+
+    // Size the cache and empty it; an unusable geometry turns it off
+    void configure(long long sizeWords, int ways, int lineWords);
+
+    bool enabled() const { return sets > 0; }
+
+    // Touch the line holding address, replacing the least recently used way of its set on a miss
+    bool access(long long address) {
+        long long line = address / lineWords;
+        size_t first = (size_t)(line % sets) * ways;
+        long long* set = &tags[first];
+        unsigned long long* used = &lastUse[first];
+        int victim = 0;
+        tick++;
+        for (int way = 0; way < ways; way++) {
+            if (set[way] == line) {
+                used[way] = tick;
+                return true;
+            }
+            if (used[way] < used[victim])
+                victim = way;
+        }
+        set[victim] = line;
+        used[victim] = tick;
+        return false;
+    }
+
+    // Empty every line
+    void flush();
+};
+
+// Min pairing heap: constant time push, amortized logarithmic pop. Nodes live
+// in one vector and are recycled, so a long run does not allocate per push.
+template <class T, class Less>
+class PairingHeap {
+public:
+    PairingHeap() : root(NIL), count(0) {}
+
+    bool empty() const { return root == NIL; }
+    size_t size() const { return count; }
+    const T& top() const { return nodes[root].value; }
+
+    void push(const T& value) {
+        int node;
+        if (freeNodes.empty()) {
+            node = (int)nodes.size();
+            nodes.push_back(Node());
+        } else {
+            node = freeNodes.back();
+            freeNodes.pop_back();
+        }
+        nodes[node].value = value;
+        nodes[node].child = NIL;
+        nodes[node].sibling = NIL;
+        root = root == NIL ? node : meld(root, node);
+        count++;
+    }
+
+    void pop() {
+        int old = root;
+        root = mergePairs(nodes[old].child);
+        freeNodes.push_back(old);
+        count--;
+    }
+
+    void clear() {
+        nodes.clear();
+        freeNodes.clear();
+        root = NIL;
+        count = 0;
+    }
+
+    // Every value, in no particular order
+    std::vector<T> values() const {
+        std::vector<T> out;
+        std::vector<int> pending;
+        if (root != NIL)
+            pending.push_back(root);
+        while (!pending.empty()) {
+            int node = pending.back();
+            pending.pop_back();
+            out.push_back(nodes[node].value);
+            for (int child = nodes[node].child; child != NIL; child = nodes[child].sibling)
+                pending.push_back(child);
+        }
+        return out;
+    }
+
+private:
+    static const int NIL = -1;
+
+    struct Node {
+        T value;
+        int child;    // first child
+        int sibling;  // next child of the same parent
+    };
+
+    // Link two roots, the larger becomes the first child of the smaller
+    int meld(int a, int b) {
+        if (less(nodes[b].value, nodes[a].value))
+            std::swap(a, b);
+        nodes[b].sibling = nodes[a].child;
+        nodes[a].child = b;
+        return a;
+    }
+
+    // Two-pass merge of a sibling list: meld pairs left to right, then the results right to left
+    int mergePairs(int first) {
+        if (first == NIL)
+            return NIL;
+        pairs.clear();
+        while (first != NIL) {
+            int a = first;
+            int b = nodes[a].sibling;
+            if (b == NIL) {
+                pairs.push_back(a);
+                break;
+            }
+            first = nodes[b].sibling;
+            nodes[a].sibling = NIL;
+            nodes[b].sibling = NIL;
+            pairs.push_back(meld(a, b));
+        }
+        int merged = pairs.back();
+        for (size_t i = pairs.size() - 1; i-- > 0;)
+            merged = meld(pairs[i], merged);
+        return merged;
+    }
+
+    std::vector<Node> nodes;
+    std::vector<int> freeNodes;
+    std::vector<int> pairs;  // scratch for mergePairs
+    int root;
+    size_t count;
+    Less less;
+};
+
+// A ready process under EDF, RMS or stride scheduling, ordered by key and then by when it became ready
+struct ReadyEntry {
+    long long key;    // deadline, period or pass; LLONG_MAX for none
+    long long order;
+    PCB* process;
+
+    bool operator<(const ReadyEntry& other) const {
+        return key != other.key ? key < other.key : order < other.order;
+    }
+};
+
+// Fenwick tree over process slots holding the tickets of the ready ones, for
+// lottery scheduling: adding, removing and drawing are O(log n)
+class TicketTree {
+public:
+    TicketTree() : tree(1, 0), members(0) {}
+
+    // Make room for slots [0, slots), keeping the tickets already held
+    void resize(size_t slots);
+
+    void add(int slot, long long tickets, int memberDelta) {
+        members += memberDelta;
+        for (size_t i = (size_t)slot + 1; i < tree.size(); i += i & (0 - i))
+            tree[i] += tickets;
+    }
+
+    long long total() const { return ticketsBefore(tree.size() - 1); }
+    size_t size() const { return (size_t)members; }
+    bool empty() const { return members == 0; }
+
+    // Slot holding ticket number draw, 0 <= draw < total()
+    int find(long long draw) const {
+        size_t position = 0;
+        size_t step = 1;
+        while (step * 2 < tree.size())
+            step *= 2;
+        for (; step > 0; step /= 2) {
+            if (position + step < tree.size() && tree[position + step] <= draw) {
+                position += step;
+                draw -= tree[position];
+            }
+        }
+        return (int)position;
+    }
+
+    // Tickets held by the slot
+    long long held(int slot) const { return ticketsBefore(slot + 1) - ticketsBefore(slot); }
+
+    void clear() {
+        tree.assign(1, 0);
+        members = 0;
+    }
+
+private:
+    // Tickets of slots [0, count)
+    long long ticketsBefore(size_t count) const {
+        long long sum = 0;
+        for (size_t i = count; i > 0; i -= i & (0 - i))
+            sum += tree[i];
+        return sum;
+    }
+
+    std::vector<long long> tree;  // 1-based
+    long long members;
+};
+
+// xoshiro256** seeded through SplitMix64: fast, and the same seed gives the
+// same sequence on every platform
+struct LotteryRandom {
+    unsigned long long state[4];
+
+    explicit LotteryRandom(unsigned long long seed = 1) { reseed(seed); }
+
+    void reseed(unsigned long long seed) {
+        for (int i = 0; i < 4; i++) {
+            unsigned long long z = (seed += 0x9e3779b97f4a7c15ULL);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            state[i] = z ^ (z >> 31);
+        }
+    }
+
+    unsigned long long next() {
+        unsigned long long result = rotate(state[1] * 5, 7) * 9;
+        unsigned long long t = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotate(state[3], 45);
+        return result;
+    }
+
+    // Uniform in [0, bound) without modulo bias (Lemire's multiply and reject)
+    unsigned long long below(unsigned long long bound) {
+        unsigned __int128 product = (unsigned __int128)next() * bound;
+        if ((unsigned long long)product < bound) {
+            unsigned long long threshold = (0 - bound) % bound;
+            while ((unsigned long long)product < threshold)
+                product = (unsigned __int128)next() * bound;
+        }
+        return (unsigned long long)(product >> 64);
+    }
+
+private:
+    static unsigned long long rotate(unsigned long long x, int k) { return (x << k) | (x >> (64 - k)); }
+};
+
+// Live counters of a running simulation. The simulator thread is the only
+// writer and publishes them with relaxed stores, at most once per event;
+// other threads may read them at any time, each value on its own.
+struct SimulatorStats {
+    std::atomic<long long> clock;              // global clock after the last slice
+    std::atomic<long long> instructions;       // instructions executed
+    std::atomic<long long> totalInstructions;  // instructions of every loaded job
+    std::atomic<long long> dispatches;
+    std::atomic<long long> ioCompletions;
+    std::atomic<long long> readyDepth;         // ready queue length after the last slice
+    std::atomic<long long> ioWaitingDepth;     // I/O waiting queue length after the last slice
+    std::atomic<long long> terminated;
+    std::atomic<long long> jobs;
+    std::atomic<long long> admissionWaiting;   // jobs waiting for memory; at the limit new jobs are rejected
+
+    SimulatorStats() :
+        clock(0), instructions(0), totalInstructions(0), dispatches(0), ioCompletions(0),
+        readyDepth(0), ioWaitingDepth(0), terminated(0), jobs(0), admissionWaiting(0) {}
+};
+
+// Log-linear histogram of non-negative values in fixed memory, in the style
+// of HdrHistogram: values below 64 are exact and larger ones fall into one
+// of 32 buckets per power of two, so a bucket is within 1/32 of its values.
+// Recording is lock-free and safe from several threads at once.
+class Histogram {
+public:
+    Histogram() { clear(); }
+
+    // Add one sample, negative values count as 0
+    void record(long long value);
+
+    // Drop every sample; not safe while other threads record
+    void clear();
+
+    long long count() const { return total.load(std::memory_order_relaxed); }
+    long long min() const { return count() > 0 ? minimum.load(std::memory_order_relaxed) : 0; }
+    long long max() const { return maximum.load(std::memory_order_relaxed); }
+    double mean() const { return count() > 0 ? (double)sum.load(std::memory_order_relaxed) / count() : 0; }
+
+    // Highest value of the bucket holding the given percentile of the samples, at most max()
+    long long percentile(double percent) const;
+
+private:
+    static const int LINEAR_BUCKETS = 64;
+    static const int SUB_BUCKETS = 32;
+    static const int BUCKETS = LINEAR_BUCKETS + 57 * SUB_BUCKETS;  // up to LLONG_MAX
+
+    static int bucketOf(long long value);
+    static long long bucketHigh(int bucket);
+
+    Histogram(const Histogram&);
+    Histogram& operator=(const Histogram&);
+
+    std::atomic<long long> counts[BUCKETS];
+    std::atomic<long long> total;
+    std::atomic<long long> sum;
+    std::atomic<long long> minimum;
+    std::atomic<long long> maximum;
+};
+
+// Scheduler distributions a Simulator records into when given one
+struct SchedulerHistograms {
+    Histogram readyDepth;        // ready queue length left behind at each dispatch
+    Histogram ioWaitingDepth;    // I/O waiting queue length at each dispatch
+    Histogram readyWait;         // cycles from entering the ready queue to running
+    Histogram ioLatency;         // cycles from issuing a PRINT to its completion
+    Histogram ioDelay;           // cycles from an I/O release time to the completion being handled
+    Histogram mailboxLength;     // messages in the mailbox after each SEND or RECV
+    Histogram messageBlocking;   // cycles a blocked SEND or RECV waited
+    Histogram admissionDelay;    // cycles a job waited for memory before it was admitted
+    Histogram lateness;          // cycles a job finished after its deadline, for the ones that missed it
+    Histogram sliceUtilization;  // cycles used by a slice, in percent of CPUAllocated
+
+    void clear();
+
+    // Print one row of percentiles per histogram
+    void print(std::ostream& out) const;
+};
+
+// CPU scheduler (round robin, EDF, RMS, stride or lottery, see
+// SchedulingPolicy) and main memory simulation. Load jobs with
+// readJobs (job file) or configure + loadJobs, then drive it with step,
+// runUntil or run. A Simulator can be reset and reused; its memory mapping
+// is kept between runs.
+class Simulator {
+public:
+    typedef std::function<void(const SimulatorEvent&)> EventHook;
+
+    Simulator();
+    ~Simulator();
+
+    void configure(const SimulatorConfig& config);
+    const SimulatorConfig& config() const { return settings; }
+
+    // Stream for the text trace, NULL for none
+    void setOutput(std::ostream* out) { output = out; }
+
+    // Distributions to record while running, NULL for none; may be shared between simulators
+    void setHistograms(SchedulerHistograms* into) { histograms = into; }
+
+    // Hook called for every event, in order
+    void addEventHook(const EventHook& hook) { hooks.push_back(hook); }
+
+    // Write a binary event log, with the current memory image as its header when withMemory is
+    // set and the memory has at most INT_MAX words
+    bool openEventLog(const char* path, bool withMemory);
+
+    // Read the system parameters and jobs of a job file and load them; false on a parse error
+    bool readJobs(JobReader& input);
+
+    // Set the capacity of a mailbox before the run; undeclared mailboxes hold one message
+    void declareMailbox(int mailboxID, int capacity) { mailboxes[mailboxID] = Mailbox(capacity); }
+
+    // Lay out jobs in order and load them into main memory; jobs are consumed.
+    // Jobs from the first one that does not fit on wait for admission.
+    // False if the simulated memory could not be mapped.
+    bool loadJobs(std::vector<JobRecord>& jobs);
+
+    // Backpressure: false while the admission queue is at its limit, so a job
+    // that does not fit would be rejected
+    bool acceptingJobs() const {
+        return settings.admissionLimit == 0 ||
+               arrivals.size() + admissionQueue.size() < (size_t)settings.admissionLimit;
+    }
+
+    // Print every main memory word
+    void printMemory();
+
+    // Dispatch the next process for one slice; false once every process has terminated
+    bool step();
+
+    // Step until the clock reaches time or every process has terminated
+    void runUntil(long long time);
+
+    // Step until every process has terminated
+    void run();
+
+    bool finished() const { return readyCount() == 0 && ioWaitingQueue.empty(); }
+    long long clock() const { return globalClock; }
+    const SimulatedMemory& memory() const { return mainMemory; }
+    const std::vector<PCB*>& jobs() const { return processes; }
+    const std::map<int,long long>& terminationTimes() const { return terminations; }
+    const std::map<int,std::vector<PCB*> >& groups() const { return processGroups; }
+    const std::map<int,Mailbox>& mailboxStates() const { return mailboxes; }
+    size_t readyCount() const { return readyQueue.size() + readyHeap.size() + lotteryReady.size(); }
+
+    // Counters safe to sample from another thread while the simulation runs
+    const SimulatorStats& statistics() const { return stats; }
+
+    // Snapshot the complete state; restore it into this simulator
+    bool saveCheckpoint(const char* path) const;
+    bool loadCheckpoint(const char* path);
+
+    // Restore a checkpoint image already in memory, as sent to the server
+    bool restoreCheckpoint(const char* data, size_t size);
+
+    // Drop all jobs and state and return to the configured settings, keeping hooks and buffers
+    void reset();
+
+private:
+    void emit(int type, const PCB* process, int instruction, long long value, const long long* pcbWords = NULL);
+    void emitRecord(const LogRecord& record, const PCB* process, const long long* pcbWords = NULL);
+    bool observed() const { return output != NULL || eventLog != NULL || !hooks.empty() || histograms != NULL; }
+    void ioQueueCheck();
+    template <class Policy> void advanceClock(long long cycles);
+    template <class Policy> void trace(int type, const PCB* process, int instruction, long long value);
+    template <class Policy> void runSlice(PCB* currentProc);
+    void gatherGroup();
+    long long memoryCost(PCB& process, int address);
+    long long computeTime(int cycles) const;
+    void governFrequency();
+    long long allocateMemory(long long words);
+    void releaseMemory(long long base, long long words);
+    void placeJob(PCB& process, long long base, bool reused);
+    void admitJobs();
+    void reject(PCB* process, int reason);
+    PCB* dequeueReady();
+    void closeShareWindow();
+    bool sendMessage(PCB* sender, int mailboxID);
+    bool receiveMessage(PCB* receiver, int mailboxID);
+    void unblock(PCB* process, int mailboxID, Mailbox& box, bool wasSending);
+    void terminate(PCB* currentProc);
+    void reportTotal();
+    void closeEventLog();
+    void publishTotals();
+
+    Simulator(const Simulator&);
+    Simulator& operator=(const Simulator&);
+
+    SimulatorConfig configured;  // as given to configure, reset returns to it
+    SimulatorConfig settings;    // in effect for the loaded jobs
+    std::ostream* output;
+    SchedulerHistograms* histograms;
+    FILE* eventLog;
+    std::vector<EventHook> hooks;
+
+    ProgramTable programTable;       // Shared copies of identical instruction streams
+    SimulatedMemory mainMemory;      // Simulated main memory
+    std::vector<PCB*> processes;     // List of dynamically allocated processes
+    std::deque<PCB*> readyQueue;     // Queue for ready processes, preempting I/O completions go in front
+    PairingHeap<ReadyEntry, std::less<ReadyEntry> > readyHeap;  // EDF and RMS: readyQueue is moved here at dispatch
+    long long readyOrder;            // ReadyEntry::order of the next process moved into readyHeap
+    TicketTree lotteryReady;         // lottery: readyQueue is moved here at dispatch
+    LotteryRandom lottery;
+    long long globalPass;            // stride: pass of the last dispatched process
+    long long shareWindowEnd;        // time of the first termination, -1 before it
+    std::queue<PCB*> ioWaitingQueue; // Queue for processes waiting for I/O
+    long long nextIoRelease;         // earliest ioReleaseTime in ioWaitingQueue, LLONG_MAX if empty
+    size_t preemptingReady;          // completions put in front of readyQueue during this slice
+    bool ioInterrupted;              // a completion was delivered during the current instruction
+    long long globalClock;
+    std::map<int,long long> terminations;  // termination times by process ID
+    std::map<int,std::vector<PCB*> > processGroups;  // members by group ID
+    int activeGroup;                 // group whose members are being dispatched back to back
+    std::map<int,Mailbox> mailboxes; // by mailbox ID, created on first use
+    CacheModel cache;                // prices STORE and LOAD when settings.cacheWords is set
+    int frequencyLevel;              // index into settings.frequencyLevels
+    long long busyTime;              // ticks spent running slices, for the energy report
+    long long busyEnergy;            // thousandths of an energy unit used by those slices
+    std::map<long long,long long> freeMemory;  // free regions of main memory, length by base
+    std::vector<PCB*> arrivals;      // loaded jobs that did not fit, not yet queued for admission
+    std::map<std::pair<long long,int>,PCB*> admissionQueue;  // by policy key, then arrival order
+    long long admissionWaited;       // jobs admitted after waiting
+    long long admissionRejected;
+    long long admissionDelayTotal;   // cycles the admitted jobs waited
+    long long admissionDelayMax;
+    long long deadlineJobs;          // terminated processes that had a deadline
+    long long deadlineMisses;
+    long long latenessTotal;
+    long long latenessMax;
+    bool totalReported;
+    SimulatorStats stats;
+};
+
+// Prints a line of a simulator's statistics every interval on its own thread:
+// simulated cycles per second, progress through the instructions and an ETA
+// from the average instruction rate. A last line is printed when it stops.
+class ProgressMonitor {
+public:
+    ProgressMonitor(const SimulatorStats& stats, std::ostream& out, int intervalMs);
+
+    // Stop sampling and print the final line
+    ~ProgressMonitor();
+
+private:
+    void sampleLoop();
+    void printSample(double elapsed, double interval);
+
+    ProgressMonitor(const ProgressMonitor&);
+    ProgressMonitor& operator=(const ProgressMonitor&);
+
+    const SimulatorStats& stats;
+    std::ostream& out;
+    int intervalMs;
+    long long firstInstructions;  // already executed when sampling started, as after a restore
+    long long lastClock;
+    std::mutex lock;
+    std::condition_variable wake;
+    bool stopping;
+    std::thread sampler;
+};
+
+#endif
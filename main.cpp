@@ -3,6 +3,8 @@
 #include <vector>
 #include <string>
 #include <sstream>
+#include <map>
+#include <cstdlib>
 
 using namespace std;
 
@@ -31,26 +33,30 @@ struct PCB {
     int instructionBase;
     int dataBase;
     int memoryLimit;
-    int cpuCyclesUsed;
+    long long cpuCyclesUsed;  // header word 6 holds the low 32 bits
     int registerValue;
     int maxMemoryNeeded;
     int mainMemoryBase;
     int numInstructions;
-    int startTime;      // Time when process first entered running state
-    int endTime;        // Time when process terminated
-    int ioReturnTime;   // Time when I/O operation will complete
+    long long startTime;      // Time when process first entered running state
+    long long endTime;        // Time when process terminated
+    long long ioReturnTime;   // Time when I/O operation will complete
 };
 
 // Global variables
 int CPUAllocated;      // Max CPU time allocation before timeout
 int contextSwitchTime; // Time to switch context
-int globalCPUClock = 0; // Global CPU clock
+long long globalCPUClock = 0; // Global CPU clock
+map<int, long long> cyclesUsedByBase; // full CPU cycle counts by PCB address, memory only keeps 32 bits
+map<int, long long> startTimeByBase;  // first start time by PCB address, memory has no word for it
 
 // Function prototypes
 void loadJobsToMemory(vector<PCB>& processes, vector<int>& mainMemory, queue<int>& readyQueue);
 void executeCPU(int startAddress, vector<int>& mainMemory, queue<int>& readyQueue, queue<PCB>& ioWaitingQueue);
 void checkIOWaitingQueue(queue<PCB>& ioWaitingQueue, queue<int>& readyQueue, vector<int>& mainMemory);
 void printMainMemory(vector<int>& mainMemory);
+void saveContext(const PCB& process, int startAddress, vector<int>& mainMemory);
+void addCycles(long long& total, long long cycles);
 string getStateString(ProcessState state);
 
 int main() {
@@ -122,7 +128,7 @@ int main() {
             executeCPU(startAddress, mainMemory, readyQueue, ioWaitingQueue);
         } else if (!ioWaitingQueue.empty()) {
             // If only I/O jobs are running, increment CPU clock
-            globalCPUClock += contextSwitchTime;
+            addCycles(globalCPUClock, contextSwitchTime);
             
             // Check again if any I/O operations have completed
             checkIOWaitingQueue(ioWaitingQueue, readyQueue, mainMemory);
@@ -262,10 +268,15 @@ void executeCPU(int startAddress, vector<int>& mainMemory, queue<int>& readyQueu
     process.instructionBase = mainMemory[startAddress + 3];
     process.dataBase = mainMemory[startAddress + 4];
     process.memoryLimit = mainMemory[startAddress + 5];
-    process.cpuCyclesUsed = mainMemory[startAddress + 6];
+    // memory only has the low 32 bits, the rest comes from the last saved count
+    long long savedCycles = cyclesUsedByBase[startAddress];
+    process.cpuCyclesUsed = savedCycles - (int)savedCycles + mainMemory[startAddress + 6];
     process.registerValue = mainMemory[startAddress + 7];
     process.maxMemoryNeeded = mainMemory[startAddress + 8];
     process.mainMemoryBase = mainMemory[startAddress + 9];
+    process.startTime = -1;    // Not started yet
+    process.endTime = -1;      // Not terminated yet
+    process.ioReturnTime = -1; // No I/O pending
     
     // Calculate the number of instructions based on dataBase - instructionBase
     process.numInstructions = (process.dataBase - process.instructionBase) / 3; // Each instruction takes 3 integers
@@ -275,17 +286,18 @@ void executeCPU(int startAddress, vector<int>& mainMemory, queue<int>& readyQueu
     mainMemory[startAddress + 1] = RUNNING;
     
     // Record start time if this is the first time the process is running
-    if (process.cpuCyclesUsed == 0) {
-        process.startTime = globalCPUClock;
+    if (startTimeByBase.find(startAddress) == startTimeByBase.end()) {
+        startTimeByBase[startAddress] = globalCPUClock;
     }
+    process.startTime = startTimeByBase[startAddress];
     
     cout << "Process " << process.processID << " has moved to Running." << endl;
     
     // Add context switch time
-    globalCPUClock += contextSwitchTime;
+    addCycles(globalCPUClock, contextSwitchTime);
     
     // Execute instructions until timeout, I/O operation, or completion
-    int currentCPUTime = 0;
+    long long currentCPUTime = 0;
     bool terminated = false;
     
     while (process.programCounter < process.numInstructions && currentCPUTime < CPUAllocated && !terminated) {
@@ -299,45 +311,45 @@ void executeCPU(int startAddress, vector<int>& mainMemory, queue<int>& readyQueu
         if (instructionType == COMPUTE) {
             int iterations = mainMemory[instructionAddress + 1];
             int cycles = mainMemory[instructionAddress + 2];
-            int totalCycles = iterations * cycles;
+            long long totalCycles = (long long)iterations * cycles;
             
             cout << "compute" << endl;
             
             // Update CPU cycles used
-            process.cpuCyclesUsed += totalCycles;
-            mainMemory[startAddress + 6] = process.cpuCyclesUsed;
+            addCycles(process.cpuCyclesUsed, totalCycles);
             
             // Update current CPU time
-            currentCPUTime += totalCycles;
+            addCycles(currentCPUTime, totalCycles);
             
             // Update global CPU clock
-            globalCPUClock += totalCycles;
+            addCycles(globalCPUClock, totalCycles);
             
             // Increment program counter
             process.programCounter++;
-            mainMemory[startAddress + 2] = process.programCounter;
         } else if (instructionType == PRINT) {
             int cycles = mainMemory[instructionAddress + 1];
             
             cout << "Process " << process.processID << " issued an IOInterrupt and moved to the IOWaitingQueue." << endl;
             
             // Update CPU cycles used
-            process.cpuCyclesUsed += 1;  // Count 1 cycle for initiating the I/O
-            mainMemory[startAddress + 6] = process.cpuCyclesUsed;
+            addCycles(process.cpuCyclesUsed, 1);  // Count 1 cycle for initiating the I/O
             
             // Update global CPU clock
-            globalCPUClock += 1;
+            addCycles(globalCPUClock, 1);
             
             // Set state to IOWAITING
             process.state = IOWAITING;
             mainMemory[startAddress + 1] = IOWAITING;
             
             // Set I/O return time
-            process.ioReturnTime = globalCPUClock + cycles;
+            process.ioReturnTime = globalCPUClock;
+            addCycles(process.ioReturnTime, cycles);
             
             // Increment program counter
             process.programCounter++;
-            mainMemory[startAddress + 2] = process.programCounter;
+            
+            // Save context before leaving the CPU
+            saveContext(process, startAddress, mainMemory);
             
             // Move process to I/O waiting queue
             ioWaitingQueue.push(process);
@@ -358,24 +370,21 @@ void executeCPU(int startAddress, vector<int>& mainMemory, queue<int>& readyQueu
                 
                 // Update register value
                 process.registerValue = value;
-                mainMemory[startAddress + 7] = value;
             } else {
                 cout << "store error!" << endl;
             }
             
             // Update CPU cycles used
-            process.cpuCyclesUsed += 1; // Store takes 1 CPU cycle
-            mainMemory[startAddress + 6] = process.cpuCyclesUsed;
+            addCycles(process.cpuCyclesUsed, 1); // Store takes 1 CPU cycle
             
             // Update current CPU time
-            currentCPUTime += 1;
+            addCycles(currentCPUTime, 1);
             
             // Update global CPU clock
-            globalCPUClock += 1;
+            addCycles(globalCPUClock, 1);
             
             // Increment program counter
             process.programCounter++;
-            mainMemory[startAddress + 2] = process.programCounter;
         } else if (instructionType == LOAD) {
             int address = mainMemory[instructionAddress + 1];
             
@@ -389,24 +398,21 @@ void executeCPU(int startAddress, vector<int>& mainMemory, queue<int>& readyQueu
                 
                 // Update register value
                 process.registerValue = value;
-                mainMemory[startAddress + 7] = value;
             } else {
                 cout << "load error!" << endl;
             }
             
             // Update CPU cycles used
-            process.cpuCyclesUsed += 1; // Load takes 1 CPU cycle
-            mainMemory[startAddress + 6] = process.cpuCyclesUsed;
+            addCycles(process.cpuCyclesUsed, 1); // Load takes 1 CPU cycle
             
             // Update current CPU time
-            currentCPUTime += 1;
+            addCycles(currentCPUTime, 1);
             
             // Update global CPU clock
-            globalCPUClock += 1;
+            addCycles(globalCPUClock, 1);
             
             // Increment program counter
             process.programCounter++;
-            mainMemory[startAddress + 2] = process.programCounter;
         }
         
         // Check if process has completed all instructions
@@ -440,6 +446,9 @@ void executeCPU(int startAddress, vector<int>& mainMemory, queue<int>& readyQueu
         }
     }
     
+    // Save context at the end of the slice
+    saveContext(process, startAddress, mainMemory);
+    
     // If process timed out, move it back to the ready queue
     if (!terminated && currentCPUTime >= CPUAllocated) {
         cout << "Process " << process.processID << " has a TimeOUT interrupt and is moved to the ReadyQueue." << endl;
@@ -483,6 +492,27 @@ void checkIOWaitingQueue(queue<PCB>& ioWaitingQueue, queue<int>& readyQueue, vec
     ioWaitingQueue = tempQueue;
 }
 
+// Write the PCB words that change while running back to main memory
+void saveContext(const PCB& process, int startAddress, vector<int>& mainMemory) {
+    mainMemory[startAddress + 2] = process.programCounter;
+    mainMemory[startAddress + 6] = (int)process.cpuCyclesUsed;
+    mainMemory[startAddress + 7] = process.registerValue;
+    cyclesUsedByBase[startAddress] = process.cpuCyclesUsed;
+}
+
+// Add cycles to the clock or a cycle counter; build with -DOVERFLOW_CHECKED
+// to stop with an error where the counter would otherwise wrap
+void addCycles(long long& total, long long cycles) {
+#ifdef OVERFLOW_CHECKED
+    if (__builtin_add_overflow(total, cycles, &total)) {
+        cerr << "Cycle count overflow: adding " << cycles << " cycles overflows 64 bits" << endl;
+        abort();
+    }
+#else
+    total += cycles;
+#endif
+}
+
 // Print the content of main memory
 void printMainMemory(vector<int>& mainMemory) {
     for (int i = 0; i < mainMemory.size(); i++) {
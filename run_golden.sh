@@ -0,0 +1,198 @@
+#!/bin/sh
+# Regression check, run by `make check`:
+#  - the trace of sampleInput2.txt must match every golden copy byte for byte
+#  - each fixture in golden/ (job files using the directives and the newer
+#    opcodes) must print its expected trace under the listed options
+#  - for several option sets on the sample, and for every fixture case,
+#    --expand-log of the event log must match the text trace, and a run
+#    restored from a checkpoint must print exactly the tail of the
+#    uninterrupted trace
+#  - a server worker that restored a checkpoint runs the next job file with
+#    its own settings
+#  - a large generated job set (see generate_jobs) must still produce the
+#    trace recorded in golden_baseline.txt; its best-of-three wall time is
+#    printed next to the recorded one
+# The baseline is only written by `make baseline` (run_golden.sh --baseline).
+# Set BASELINE= (empty) to skip the large run, as `make check-debug` does for
+# its unoptimized build.
+#
+# usage: run_golden.sh [--baseline] [binary]   (default ./project2)
+
+WRITE_BASELINE=0
+if [ "$1" = "--baseline" ]; then
+    WRITE_BASELINE=1
+    shift
+fi
+BIN=${1:-./project2}
+INPUT=sampleInput2.txt
+GOLDEN="sampleOutput2.txt 2jr.txt reese1.txt"
+BASELINE=${BASELINE-golden_baseline.txt}
+CHECKPOINT_TIMES="5 50 100 150"
+FIXTURE_TIMES="5 15 30 60 100"
+# fixture cases: job file|options|expected trace, all under golden/
+FIXTURES="groups.txt||groups.out
+groups.txt|--group-rr|groups-group-rr.out
+mailbox.txt||mailbox.out
+deadlines.txt||deadlines.out
+deadlines.txt|--schedule edf|deadlines-edf.out
+deadlines.txt|--schedule rms|deadlines-rms.out
+tickets.txt|--schedule stride|tickets-stride.out
+tickets.txt|--schedule lottery 7|tickets-lottery.out
+admission.txt|--admission fifo|admission-fifo.out
+admission.txt|--admission smallest|admission-smallest.out
+admission.txt|--admission deadline|admission-deadline.out
+admission.txt|--admission fifo 1|admission-fifo-1.out"
+LARGE_JOBS=20000
+
+if [ ! -x "$BIN" ]; then
+    echo "run_golden.sh: $BIN is not built" >&2
+    exit 1
+fi
+
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+failures=0
+
+fail() {
+    echo "FAIL $*"
+    failures=$((failures + 1))
+}
+
+now_ms() {
+    echo $(($(date +%s%N) / 1000000))
+}
+
+# Print a job file of $1 jobs with 20 COMPUTE/PRINT/STORE/LOAD instructions
+# each. A fixed LCG (exact in awk's doubles) makes it the same everywhere.
+generate_jobs() {
+    awk -v jobs="$1" 'BEGIN {
+        x = 1
+        print jobs * 80; print 5; print 2; print jobs
+        for (j = 1; j <= jobs; j++) {
+            line = j " 50 20"
+            for (i = 0; i < 20; i++) {
+                x = (x * 69069 + 1) % 4294967296; op = int(x / 1073741824) + 1
+                x = (x * 69069 + 1) % 4294967296; a = int(x / 65536) % 20 + 1
+                x = (x * 69069 + 1) % 4294967296; b = int(x / 65536) % 55
+                if (op == 1) line = line " 1 " a " " a
+                else if (op == 2) line = line " 2 " a
+                else if (op == 3) line = line " 3 " a " " b
+                else line = line " 4 " b
+            }
+            print line
+        }
+    }'
+}
+
+# golden copies
+"$BIN" < "$INPUT" > "$TMP/trace"
+for golden in $GOLDEN; do
+    if cmp -s "$TMP/trace" "$golden"; then
+        echo "ok   $golden"
+    else
+        fail "$golden differs from the trace of $INPUT"
+    fi
+done
+
+# event log and checkpoint round trips of one input under one option set
+# usage: round_trip name input "options" "checkpoint times"
+round_trip() {
+    name=$1 input=$2 options=$3
+    # shellcheck disable=SC2086
+    "$BIN" $options --log "$TMP/log" < "$input" > "$TMP/full"
+    if "$BIN" --expand-log "$TMP/log" | cmp -s - "$TMP/full"; then
+        echo "ok   $name: --expand-log"
+    else
+        fail "$name: --expand-log differs from the text trace"
+    fi
+    for time in $4; do
+        rm -f "$TMP/checkpoint"
+        # shellcheck disable=SC2086
+        "$BIN" $options --checkpoint "$time" "$TMP/checkpoint" < "$input" > /dev/null
+        [ -f "$TMP/checkpoint" ] || continue  # the run ended before this time
+        # shellcheck disable=SC2086
+        if ! "$BIN" $options --restore "$TMP/checkpoint" > "$TMP/restored"; then
+            fail "$name: restore at $time"
+        elif tail -c "$(wc -c < "$TMP/restored")" "$TMP/full" | cmp -s - "$TMP/restored"; then
+            echo "ok   $name: restore at $time"
+        else
+            fail "$name: restore at $time does not continue the trace"
+        fi
+    done
+}
+
+for options in "" "--io-interrupts preempt" "--group-rr" "--cache 256 4 8" "--dvfs" \
+               "--admission smallest 2" "--schedule edf" "--schedule rms" "--schedule stride" \
+               "--schedule lottery 7"; do
+    round_trip "${options:-default}" "$INPUT" "$options" "$CHECKPOINT_TIMES"
+done
+
+# fixtures: expected trace, then the same round trips
+while IFS='|' read -r input options expected <&3; do
+    name="golden/$input${options:+ $options}"
+    # shellcheck disable=SC2086
+    if "$BIN" $options < "golden/$input" | cmp -s - "golden/$expected"; then
+        echo "ok   $name"
+    else
+        fail "$name differs from golden/$expected"
+    fi
+    round_trip "$name" "golden/$input" "$options" "$FIXTURE_TIMES"
+done 3<<EOF
+$FIXTURES
+EOF
+
+# a server worker restores a checkpoint taken under other options, then runs
+# a plain job file; the second run must not inherit the restored settings
+"$BIN" --schedule lottery 5 --checkpoint 50 "$TMP/checkpoint" < "$INPUT" > /dev/null
+"$BIN" --serve "$TMP/socket" 1 2> /dev/null &
+server=$!
+for _ in 1 2 3 4 5 6 7 8 9 10; do
+    [ -S "$TMP/socket" ] && break
+    sleep 0.2
+done
+"$BIN" --submit "$TMP/socket" < "$TMP/checkpoint" > /dev/null
+if "$BIN" --submit "$TMP/socket" --trace < "$INPUT" | cmp -s - sampleOutput2.txt; then
+    echo "ok   server: job file after a restore"
+else
+    fail "server: job file after a restore does not match sampleOutput2.txt"
+fi
+kill "$server"
+
+# large generated job set: trace checksum and best-of-three wall time
+if [ -n "$BASELINE" ]; then
+    generate_jobs "$LARGE_JOBS" > "$TMP/large"
+    best=
+    for _ in 1 2 3; do
+        start=$(now_ms)
+        "$BIN" < "$TMP/large" > "$TMP/trace"
+        elapsed=$(($(now_ms) - start))
+        if [ -z "$best" ] || [ "$elapsed" -lt "$best" ]; then
+            best=$elapsed
+        fi
+    done
+    checksum=$(cksum < "$TMP/trace" | awk '{ print $1 "-" $2 }')
+    if [ "$WRITE_BASELINE" = 1 ]; then
+        {
+            echo "# $LARGE_JOBS generated jobs, written by run_golden.sh --baseline"
+            echo "trace $checksum"
+            echo "ms $best"
+        } > "$BASELINE"
+        echo "ok   $LARGE_JOBS jobs: baseline written (${best} ms)"
+    else
+        recorded=$(awk '$1 == "trace" { print $2 }' "$BASELINE" 2> /dev/null)
+        recordedMs=$(awk '$1 == "ms" { print $2 }' "$BASELINE" 2> /dev/null)
+        if [ -z "$recorded" ]; then
+            echo "ok   $LARGE_JOBS jobs: ${best} ms (no baseline, run make baseline)"
+        elif [ "$checksum" = "$recorded" ]; then
+            echo "ok   $LARGE_JOBS jobs: ${best} ms, baseline ${recordedMs} ms"
+        else
+            fail "$LARGE_JOBS jobs: the trace differs from the baseline"
+        fi
+    fi
+fi
+
+if [ "$failures" -gt 0 ]; then
+    echo "$failures check(s) failed"
+    exit 1
+fi
+echo "all checks passed"